@@ -0,0 +1,207 @@
+#include "aabbkernel.h"
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AABBKERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AABBKERNEL_TARGET_AVX2
+#else
+#define AABBKERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace AabbKernel {
+
+namespace {
+
+using OverlapFn = void (*)(const float *, const float *, const float *, const float *,
+                           int, const Box &, std::uint32_t *);
+
+// Scalar versions double as the tail loops of the vector paths
+void overlapScalar(const float *left, const float *top, const float *right, const float *bottom,
+                   int begin, int count, const Box &box, std::uint32_t *mask)
+{
+    for (int i = begin; i < count; ++i) {
+        const bool hit = box.left < right[i] && left[i] < box.right
+                      && box.top < bottom[i] && top[i] < box.bottom;
+        mask[i >> 5] |= std::uint32_t(hit) << (i & 31);
+    }
+}
+
+void overlapScalarKernel(const float *left, const float *top, const float *right, const float *bottom,
+                         int count, const Box &box, std::uint32_t *mask)
+{
+    std::memset(mask, 0, maskWords(count) * sizeof(std::uint32_t));
+    overlapScalar(left, top, right, bottom, 0, count, box, mask);
+}
+
+#ifdef AABBKERNEL_X86
+// 4 colliders per iteration; a group of 4 never straddles a mask word
+void overlapSse2(const float *left, const float *top, const float *right, const float *bottom,
+                 int count, const Box &box, std::uint32_t *mask)
+{
+    std::memset(mask, 0, maskWords(count) * sizeof(std::uint32_t));
+    const __m128 boxLeft = _mm_set1_ps(box.left);
+    const __m128 boxTop = _mm_set1_ps(box.top);
+    const __m128 boxRight = _mm_set1_ps(box.right);
+    const __m128 boxBottom = _mm_set1_ps(box.bottom);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 hit = _mm_cmplt_ps(boxLeft, _mm_loadu_ps(right + i));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(_mm_loadu_ps(left + i), boxRight));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(boxTop, _mm_loadu_ps(bottom + i)));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(_mm_loadu_ps(top + i), boxBottom));
+        mask[i >> 5] |= std::uint32_t(_mm_movemask_ps(hit)) << (i & 31);
+    }
+    overlapScalar(left, top, right, bottom, i, count, box, mask);
+}
+
+// 8 colliders per instruction
+AABBKERNEL_TARGET_AVX2
+void overlapAvx2(const float *left, const float *top, const float *right, const float *bottom,
+                 int count, const Box &box, std::uint32_t *mask)
+{
+    std::memset(mask, 0, maskWords(count) * sizeof(std::uint32_t));
+    const __m256 boxLeft = _mm256_set1_ps(box.left);
+    const __m256 boxTop = _mm256_set1_ps(box.top);
+    const __m256 boxRight = _mm256_set1_ps(box.right);
+    const __m256 boxBottom = _mm256_set1_ps(box.bottom);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 hit = _mm256_cmp_ps(boxLeft, _mm256_loadu_ps(right + i), _CMP_LT_OQ);
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(left + i), boxRight, _CMP_LT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(boxTop, _mm256_loadu_ps(bottom + i), _CMP_LT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(top + i), boxBottom, _CMP_LT_OQ));
+        mask[i >> 5] |= std::uint32_t(_mm256_movemask_ps(hit)) << (i & 31);
+    }
+    overlapScalar(left, top, right, bottom, i, count, box, mask);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+                         && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // AABBKERNEL_X86
+
+OverlapFn overlapFor(Isa isa)
+{
+    switch (isa) {
+#ifdef AABBKERNEL_X86
+    case Isa::Avx2:
+        return overlapAvx2;
+    case Isa::Sse2:
+        return overlapSse2;
+#endif
+    default:
+        return overlapScalarKernel;
+    }
+}
+
+std::atomic<int> &activeIsaStorage()
+{
+    static std::atomic<int> isa{int(bestSupportedIsa())};
+    return isa;
+}
+
+} // namespace
+
+void overlapMask(const float *left, const float *top, const float *right, const float *bottom,
+                 int count, const Box &box, std::uint32_t *mask)
+{
+    overlapFor(activeIsa())(left, top, right, bottom, count, box, mask);
+}
+
+Isa bestSupportedIsa()
+{
+#ifdef AABBKERNEL_X86
+    static const Isa best = cpuHasAvx2() ? Isa::Avx2 : Isa::Sse2;
+    return best;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+Isa activeIsa()
+{
+    return Isa(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void setIsa(Isa isa)
+{
+    if (int(isa) > int(bestSupportedIsa()))
+        isa = bestSupportedIsa();
+    activeIsaStorage().store(int(isa), std::memory_order_relaxed);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::Avx2: return "avx2";
+    case Isa::Sse2: return "sse2";
+    case Isa::Scalar: break;
+    }
+    return "scalar";
+}
+
+bool verify(Isa isa, int rounds, unsigned seed)
+{
+    if (int(isa) > int(bestSupportedIsa()))
+        return false;
+    std::mt19937 rng(seed);
+    // Half-pixel steps so equal edges, which the comparisons care about, come up often
+    auto coord = [&rng](int range) { return float(int(rng() % (range * 2))) * 0.5f; };
+
+    const OverlapFn active = overlapFor(isa);
+    const OverlapFn scalar = overlapFor(Isa::Scalar);
+    std::vector<float> left, top, right, bottom;
+    std::vector<std::uint32_t> expected, actual;
+
+    for (int round = 0; round < rounds; ++round) {
+        const int count = int(rng() % 100);
+        left.resize(count);
+        top.resize(count);
+        right.resize(count);
+        bottom.resize(count);
+        for (int i = 0; i < count; ++i) {
+            left[i] = coord(200);
+            top[i] = coord(200);
+            right[i] = left[i] + coord(60);
+            bottom[i] = top[i] + coord(60);
+        }
+
+        Box box;
+        box.left = coord(200);
+        box.top = coord(200);
+        box.right = box.left + coord(40);
+        box.bottom = box.top + coord(40);
+
+        expected.assign(maskWords(count) + 1, 0);
+        actual.assign(maskWords(count) + 1, 0);
+        scalar(left.data(), top.data(), right.data(), bottom.data(), count, box, expected.data());
+        active(left.data(), top.data(), right.data(), bottom.data(), count, box, actual.data());
+        if (expected != actual)
+            return false;
+    }
+    return true;
+}
+
+} // namespace AabbKernel
@@ -0,0 +1,60 @@
+#ifndef AABBKERNEL_H
+#define AABBKERNEL_H
+
+#include <cstdint>
+
+// Batched player-vs-level box tests over structure-of-arrays colliders.
+// Results are bitmasks: bit (i % 32) of mask[i / 32] is set when collider i
+// passes, so callers need (count + 31) / 32 words. The vector paths produce
+// bit-identical results to the scalar one; which one runs is picked once from
+// the CPU's features and can be overridden for comparisons.
+namespace AabbKernel {
+
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+struct Box
+{
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+inline int maskWords(int count) { return (count + 31) / 32; }
+
+// Strict overlap, same as QRectF::intersects()
+void overlapMask(const float *left, const float *top, const float *right, const float *bottom,
+                 int count, const Box &box, std::uint32_t *mask);
+
+Isa bestSupportedIsa();
+Isa activeIsa();
+// Falls back to the best supported ISA if the requested one isn't available
+void setIsa(Isa isa);
+const char *isaName(Isa isa);
+
+// Calls fn(index) for every set bit among the first count bits of mask
+template <typename Fn>
+void forEachHit(const std::uint32_t *mask, int count, Fn fn)
+{
+    for (int word = 0; word < maskWords(count); ++word) {
+        for (std::uint32_t bits = mask[word]; bits; bits &= bits - 1) {
+            int bit = 0;
+            while (!(bits & (1u << bit)))
+                ++bit;
+            fn(word * 32 + bit);
+        }
+    }
+}
+
+// Runs isa against the scalar path on random boxes and returns whether
+// every mask matched. Every ISA up to bestSupportedIsa() can be checked.
+bool verify(Isa isa, int rounds, unsigned seed);
+
+} // namespace AabbKernel
+
+#endif // AABBKERNEL_H
@@ -0,0 +1,239 @@
+#include "benchmarks.h"
+#include "aabbkernel.h"
+#include "gamescene.h"
+#include "levelstreamer.h"
+#include "particleitem.h"
+#include "particlepool.h"
+#include "profiler.h"
+#include "randomwalkbot.h"
+#include "world.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QTextStream>
+#include <random>
+
+namespace {
+
+// Each case runs in growing batches until it has been measured for at least
+// this long, so fast and slow cases get comparable confidence
+constexpr qint64 MinimumRunNs = 200 * 1000 * 1000;
+
+struct Result
+{
+    QString name;
+    int items{0};        // size parameter of the case, if any
+    qint64 iterations{0};
+    double nsPerOp{0};
+};
+
+template <typename Operation>
+Result measure(const QString &name, int items, Operation operation)
+{
+    operation();  // warm caches and lazy initialization
+
+    Result result;
+    result.name = name;
+    result.items = items;
+    qint64 batch = 1;
+    qint64 totalNs = 0;
+    QElapsedTimer clock;
+    while (totalNs < MinimumRunNs) {
+        clock.start();
+        for (qint64 i = 0; i < batch; ++i)
+            operation();
+        totalNs += clock.nsecsElapsed();
+        result.iterations += batch;
+        batch *= 2;
+    }
+    result.nsPerOp = double(totalNs) / result.iterations;
+    return result;
+}
+
+// Wide level with rows of one-way ledges, spike rows under them and a
+// ground strip, so the broadphase sees a realistic spread of colliders
+std::vector<std::uint8_t> syntheticLevel(int platforms, int movers)
+{
+    const int columns = qMax(1, platforms / 4);
+    const float width = qMax(800.0f, columns * 100.0f);
+
+    LevelBuilder builder;
+    builder.setBounds(width, 600);
+    builder.setSpawn(0, 470);
+    builder.addCollider({0, 550, width, 50}, ColliderKind::Solid, PlatformStyle::Ground);
+    for (int i = 0; i < platforms; ++i) {
+        const float x = (i / 4) * 100.0f + 20;
+        const float y = 150.0f + (i % 4) * 100.0f;
+        if (i % 4 == 3)
+            builder.addSpikeRow(x, y, 3);
+        else
+            builder.addCollider({x, y, 60, 20}, ColliderKind::OneWay, PlatformStyle::Ledge);
+    }
+    for (int i = 0; i < movers; ++i) {
+        const float y = 40.0f + (i % 24) * 20.0f;
+        builder.addMover({(i / 24) * 200.0f, y, 80, 10}, 0, 100, 1.0f + (i % 5) * 0.5f);
+    }
+    return builder.build();
+}
+
+bool loadSynthetic(World &world, const std::vector<std::uint8_t> &image)
+{
+    LevelView view;
+    if (!view.parse(image.data(), image.size()))
+        return false;
+    world.loadLevel(view);
+    return true;
+}
+
+// A random-walking player, put back at the start every few hundred ticks
+// so it never parks against the right edge and every pass of the collision
+// loop has something to do
+void benchWorldStep(QVector<Result> &results, int platforms)
+{
+    const std::vector<std::uint8_t> image = syntheticLevel(platforms, 0);
+    World world;
+    if (!loadSynthetic(world, image))
+        return;
+    std::vector<std::uint8_t> start(world.stateSize());
+    world.saveState(start.data());
+    RandomWalkBot bot(1);
+    unsigned events = World::NoEvent;
+    results.append(measure("world.step", platforms, [&] {
+        if (world.tick() >= 600 || (events & World::PlayerExited))
+            world.restoreState(start.data());
+        const PlayerInput input = bot.next();
+        world.setInput(input.moveLeft, input.moveRight);
+        if (input.jump)
+            world.requestJump();
+        world.step();
+        events = world.takeEvents();
+    }));
+}
+
+void benchMovers(QVector<Result> &results, int movers)
+{
+    const std::vector<std::uint8_t> image = syntheticLevel(0, movers);
+    World world;
+    if (!loadSynthetic(world, image))
+        return;
+    results.append(measure("world.step.movers", movers, [&world] {
+        world.step();
+        world.takeEvents();
+    }));
+}
+
+void benchLevelLoad(QVector<Result> &results, int platforms)
+{
+    const std::vector<std::uint8_t> image = syntheticLevel(platforms, 0);
+    World world;
+    results.append(measure("world.loadLevel", platforms, [&] { loadSynthetic(world, image); }));
+}
+
+// A screenful of long-lived sparks, refilled as they die, so every frame
+// updates and draws the whole pool
+void benchParticles(QVector<Result> &results, int particles)
+{
+    ParticlePool pool(particles);
+    std::mt19937 rng(1);
+    ParticlePool::Burst burst;
+    burst.kind = ParticleKind::Spark;
+    burst.x = 400;
+    burst.y = 300;
+    burst.count = particles;
+    burst.maxSpeed = 200;
+    burst.gravity = 100;
+    burst.minLife = 2;
+    burst.maxLife = 4;
+    auto refill = [&] {
+        burst.count = pool.capacity() - pool.size();
+        pool.spawn(burst, rng);
+    };
+    refill();
+    results.append(measure("particles.update", particles, [&] {
+        pool.update(1.0f / 60);
+        refill();
+    }));
+
+    ParticleItem item(&pool);
+    item.setBounds(QRectF(0, 0, 800, 600));
+    QImage frame(800, 600, QImage::Format_ARGB32_Premultiplied);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = item.boundingRect();
+    results.append(measure("particles.paint", particles, [&] {
+        QPainter painter(&frame);
+        item.paint(&painter, &option, nullptr);
+    }));
+}
+
+} // namespace
+
+int runBenchmarks(const QStringList &arguments)
+{
+    // The profiler would time itself along with everything else
+    Profiler::instance().setEnabled(false);
+
+    QVector<Result> results;
+    for (int platforms : {100, 1000, 10000})
+        benchWorldStep(results, platforms);
+    for (int movers : {10, 100, 1000})
+        benchMovers(results, movers);
+    for (int platforms : {100, 1000, 10000})
+        benchLevelLoad(results, platforms);
+    for (int particles : {1000, 10000, 30000})
+        benchParticles(results, particles);
+
+    results.append(measure("level.prepare", 1, [] { LevelStreamer::prepare(1, World::ReferenceTickSeconds, 1); }));
+
+    // A level switch on a scene that already exists, built on this thread:
+    // less level.prepare, what swapping in items, brushes and the arena
+    // costs the GUI thread
+    {
+        GameScene scene;
+        scene.frameScheduler()->stop();
+        scene.setBlockingLoads(true);
+        results.append(measure("scene.restart", 1, [&scene] { scene.restart(1, 1); }));
+    }
+
+    {
+        GameScene scene;
+        scene.frameScheduler()->stop();
+        QImage frame(int(scene.width()), int(scene.height()), QImage::Format_ARGB32_Premultiplied);
+        results.append(measure("scene.render", frame.width() * frame.height(), [&] {
+            QPainter painter(&frame);
+            painter.setRenderHint(QPainter::Antialiasing);
+            scene.render(&painter);
+        }));
+    }
+
+    QJsonArray benchmarks;
+    for (const Result &result : results) {
+        QJsonObject entry;
+        entry["name"] = result.name;
+        entry["items"] = result.items;
+        entry["iterations"] = result.iterations;
+        entry["nsPerOp"] = result.nsPerOp;
+        entry["opsPerSecond"] = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0.0;
+        benchmarks.append(entry);
+    }
+    QJsonObject root;
+    root["qt"] = QString::fromLatin1(qVersion());
+    root["isa"] = QString::fromLatin1(AabbKernel::isaName(AabbKernel::activeIsa()));
+    root["benchmarks"] = benchmarks;
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    if (arguments.isEmpty()) {
+        QTextStream(stdout) << json;
+        return 0;
+    }
+    QFile out(arguments.first());
+    if (!out.open(QIODevice::WriteOnly) || out.write(json) != json.size()) {
+        QTextStream(stderr) << "Cannot write " << arguments.first() << ": " << out.errorString() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+
+// Command line entry point for --bench [output.json]. Times the world step
+// against growing levels, mover updates, level and scene construction and
+// full-frame rendering into a QImage, then writes the results as JSON (to
+// stdout without a path). Needs a QApplication, which may be offscreen.
+int runBenchmarks(const QStringList &arguments);
+
+#endif // BENCHMARKS_H
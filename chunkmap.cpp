@@ -0,0 +1,95 @@
+#include "chunkmap.h"
+#include <algorithm>
+#include <cmath>
+
+void ChunkMap::build(const ColliderStore &colliders, float width, float height, float size)
+{
+    chunkSize = size;
+    inverseChunkSize = 1.0f / size;
+    columns = std::max(1, int(std::ceil(width * inverseChunkSize)));
+    rows = std::max(1, int(std::ceil(height * inverseChunkSize)));
+
+    members.assign(size_t(columns) * rows, {});
+    live.assign(members.size(), 0);
+    liveChunks.clear();
+
+    for (int i = 0; i < int(colliders.size()); ++i) {
+        if (colliders.kind[i] == ColliderKind::Moving)
+            continue;
+        const Range range = rangeFor(colliders.rect(i));
+        for (int y = range.y0; y <= range.y1; ++y)
+            for (int x = range.x0; x <= range.x1; ++x)
+                members[size_t(y) * columns + x].push_back(i);
+    }
+}
+
+void ChunkMap::clear()
+{
+    members.clear();
+    live.clear();
+    liveChunks.clear();
+    columns = 0;
+    rows = 0;
+}
+
+ChunkMap::Range ChunkMap::rangeFor(const WorldRect &rect) const
+{
+    // Anything off the level's edge belongs to the border chunks
+    auto clampColumn = [this](float v) { return std::clamp(int(std::floor(v * inverseChunkSize)), 0, columns - 1); };
+    auto clampRow = [this](float v) { return std::clamp(int(std::floor(v * inverseChunkSize)), 0, rows - 1); };
+
+    Range range;
+    range.x0 = clampColumn(rect.left);
+    range.x1 = clampColumn(rect.right());
+    range.y0 = clampRow(rect.top);
+    range.y1 = clampRow(rect.bottom());
+    return range;
+}
+
+WorldRect ChunkMap::chunkRect(int chunk) const
+{
+    // Border chunks also own whatever hangs off that edge of the level
+    constexpr float far = 1e6f;
+    const int x = chunk % columns;
+    const int y = chunk / columns;
+    const float left = x == 0 ? -far : x * chunkSize;
+    const float top = y == 0 ? -far : y * chunkSize;
+    const float right = x == columns - 1 ? far : (x + 1) * chunkSize;
+    const float bottom = y == rows - 1 ? far : (y + 1) * chunkSize;
+    return {left, top, right - left, bottom - top};
+}
+
+void ChunkMap::update(const WorldRect &view, std::vector<int> &entered, std::vector<int> &left)
+{
+    if (members.empty())
+        return;
+
+    auto padded = [&view](float pad) {
+        return WorldRect{view.left - pad, view.top - pad, view.width + 2 * pad, view.height + 2 * pad};
+    };
+    const Range keep = rangeFor(padded(chunkSize));
+    const Range want = rangeFor(padded(chunkSize * 0.5f));
+
+    for (size_t i = 0; i < liveChunks.size();) {
+        const int chunk = liveChunks[i];
+        if (keep.contains(chunk % columns, chunk / columns)) {
+            ++i;
+            continue;
+        }
+        live[size_t(chunk)] = 0;
+        left.push_back(chunk);
+        liveChunks[i] = liveChunks.back();
+        liveChunks.pop_back();
+    }
+
+    for (int y = want.y0; y <= want.y1; ++y) {
+        for (int x = want.x0; x <= want.x1; ++x) {
+            const int chunk = y * columns + x;
+            if (live[size_t(chunk)])
+                continue;
+            live[size_t(chunk)] = 1;
+            liveChunks.push_back(chunk);
+            entered.push_back(chunk);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef CHUNKMAP_H
+#define CHUNKMAP_H
+
+#include <vector>
+#include "colliderstore.h"
+
+// Static level geometry binned into square chunks, so the scene only needs
+// items for the chunks around the camera. A collider spanning several
+// chunks is listed in each of them. Moving colliders are left out; their
+// items follow the world every frame anyway.
+class ChunkMap
+{
+public:
+    static constexpr float DefaultChunkSize = 512.0f;
+
+    void build(const ColliderStore &colliders, float width, float height, float chunkSize = DefaultChunkSize);
+    void clear();
+
+    // Activates chunks within half a chunk of view and drops the ones more
+    // than a whole chunk away, so a camera hovering on a chunk edge doesn't
+    // make items come and go. Appends the chunks that came into range and
+    // the ones that left it. Costs what's near view, not the level.
+    void update(const WorldRect &view, std::vector<int> &entered, std::vector<int> &left);
+
+    int chunkCount() const { return columns * rows; }
+    int activeChunks() const { return int(liveChunks.size()); }
+    // Area a chunk's items draw; chunks on the level's edge are open on that side
+    WorldRect chunkRect(int chunk) const;
+    const std::vector<int> &colliders(int chunk) const { return members[size_t(chunk)]; }
+
+private:
+    struct Range
+    {
+        int x0{0}, y0{0}, x1{-1}, y1{-1};
+        bool contains(int x, int y) const { return x >= x0 && x <= x1 && y >= y0 && y <= y1; }
+    };
+    Range rangeFor(const WorldRect &rect) const;
+
+    float chunkSize{DefaultChunkSize};
+    float inverseChunkSize{1.0f / DefaultChunkSize};
+    int columns{0};
+    int rows{0};
+    std::vector<std::vector<int>> members;  // colliders per chunk
+    std::vector<std::uint8_t> live;         // per chunk
+    std::vector<int> liveChunks;
+};
+
+#endif // CHUNKMAP_H
@@ -0,0 +1,79 @@
+#include "colliderstore.h"
+#include <cstring>
+
+int ColliderStore::add(const WorldRect &rect, ColliderKind colliderKind, PlatformStyle colliderStyle)
+{
+    left.push_back(rect.left);
+    top.push_back(rect.top);
+    right.push_back(rect.right());
+    bottom.push_back(rect.bottom());
+    velocityX.push_back(0.0f);
+    velocityY.push_back(0.0f);
+    kind.push_back(colliderKind);
+    style.push_back(colliderStyle);
+    return int(kind.size()) - 1;
+}
+
+void ColliderStore::assign(std::size_t count, const float *lefts, const float *tops, const float *rights,
+                           const float *bottoms, const std::uint8_t *kinds, const std::uint8_t *styles)
+{
+    left.assign(lefts, lefts + count);
+    top.assign(tops, tops + count);
+    right.assign(rights, rights + count);
+    bottom.assign(bottoms, bottoms + count);
+    velocityX.assign(count, 0.0f);
+    velocityY.assign(count, 0.0f);
+    kind.resize(count);
+    style.resize(count);
+    if (count) {
+        std::memcpy(kind.data(), kinds, count);
+        std::memcpy(style.data(), styles, count);
+    }
+}
+
+void ColliderStore::clear()
+{
+    left.clear();
+    top.clear();
+    right.clear();
+    bottom.clear();
+    velocityX.clear();
+    velocityY.clear();
+    kind.clear();
+    style.clear();
+}
+
+void ColliderStore::reserve(std::size_t count)
+{
+    left.reserve(count);
+    top.reserve(count);
+    right.reserve(count);
+    bottom.reserve(count);
+    velocityX.reserve(count);
+    velocityY.reserve(count);
+    kind.reserve(count);
+    style.reserve(count);
+}
+
+void ColliderBatch::gather(const ColliderStore &store, const std::vector<int> &candidates)
+{
+    ids = candidates;
+    const std::size_t count = candidates.size();
+    left.resize(count);
+    top.resize(count);
+    right.resize(count);
+    bottom.resize(count);
+    velocityX.resize(count);
+    velocityY.resize(count);
+    kind.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const int id = candidates[i];
+        left[i] = store.left[id];
+        top[i] = store.top[id];
+        right[i] = store.right[id];
+        bottom[i] = store.bottom[id];
+        velocityX[i] = store.velocityX[id];
+        velocityY[i] = store.velocityY[id];
+        kind[i] = store.kind[id];
+    }
+}
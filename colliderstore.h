@@ -0,0 +1,87 @@
+#ifndef COLLIDERSTORE_H
+#define COLLIDERSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "worldrect.h"
+
+enum class ColliderKind : std::uint8_t
+{
+    Solid,   // blocks from every side
+    OneWay,  // can only be landed on from above
+    Hazard,  // kills on touch
+    Moving   // solid, moved by the world every tick; carries riders
+};
+
+// Render hint carried alongside each collider; physics ignores it
+enum class PlatformStyle : std::uint8_t
+{
+    Ground,
+    Ledge,
+    Spike,
+    Mover
+};
+
+// Structure-of-arrays storage for every collider in a level. The physics step
+// reads the edge arrays directly, so a narrowphase pass is a linear walk over
+// packed floats rather than a chase through scene items.
+class ColliderStore
+{
+public:
+    int add(const WorldRect &rect, ColliderKind kind, PlatformStyle style);
+    // Replaces the contents with packed arrays, one bulk copy per array
+    void assign(std::size_t count, const float *lefts, const float *tops, const float *rights,
+                const float *bottoms, const std::uint8_t *kinds, const std::uint8_t *styles);
+    void clear();
+    void reserve(std::size_t count);
+
+    std::size_t size() const { return kind.size(); }
+    WorldRect rect(int index) const
+    {
+        return {left[index], top[index], right[index] - left[index], bottom[index] - top[index]};
+    }
+    // Moves a collider and records how far it went this tick
+    void moveTo(int index, float x, float y)
+    {
+        const float dx = x - left[index];
+        const float dy = y - top[index];
+        left[index] = x;
+        top[index] = y;
+        right[index] += dx;
+        bottom[index] += dy;
+        velocityX[index] = dx;
+        velocityY[index] = dy;
+    }
+
+    std::vector<float> left;
+    std::vector<float> top;
+    std::vector<float> right;
+    std::vector<float> bottom;
+    // Displacement over the last tick, zero for static geometry
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<ColliderKind> kind;
+    std::vector<PlatformStyle> style;
+};
+
+// Candidates copied out of a store into packed arrays, so the batched
+// narrowphase kernels can run over the ids a broadphase query returned
+class ColliderBatch
+{
+public:
+    void gather(const ColliderStore &store, const std::vector<int> &ids);
+
+    int size() const { return int(ids.size()); }
+
+    std::vector<int> ids;
+    std::vector<float> left;
+    std::vector<float> top;
+    std::vector<float> right;
+    std::vector<float> bottom;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<ColliderKind> kind;
+};
+
+#endif // COLLIDERSTORE_H
@@ -0,0 +1,73 @@
+#include "deltacodec.h"
+#include <cstring>
+
+namespace {
+
+constexpr std::size_t TokenBytes = 4;
+constexpr std::size_t MaxRun = 0xffff;
+
+} // namespace
+
+namespace DeltaCodec {
+
+std::size_t maxEncodedSize(std::size_t size)
+{
+    // Worst case: a token for every five bytes, plus the first and the last
+    return size + (size / 5 + 2) * TokenBytes;
+}
+
+std::size_t encode(const std::uint8_t *delta, std::size_t size, std::uint8_t *out)
+{
+    // Short gaps of zeros stay inside a literal; a token costs more than them
+    std::size_t written = 0;
+    std::size_t i = 0;
+    while (i < size) {
+        std::size_t zeros = 0;
+        while (i + zeros < size && delta[i + zeros] == 0 && zeros < MaxRun)
+            ++zeros;
+        const std::size_t start = i + zeros;
+        std::size_t end = start;
+        while (end < size && end - start < MaxRun) {
+            if (delta[end] == 0) {
+                // Four zeros in a row are worth a new token
+                std::size_t gap = 0;
+                while (end + gap < size && delta[end + gap] == 0 && gap < TokenBytes)
+                    ++gap;
+                if (gap == TokenBytes || end + gap == size || end + gap - start > MaxRun)
+                    break;
+                end += gap;
+                continue;
+            }
+            ++end;
+        }
+        const std::uint16_t runs[2] = {std::uint16_t(zeros), std::uint16_t(end - start)};
+        std::memcpy(out + written, runs, TokenBytes);
+        std::memmove(out + written + TokenBytes, delta + start, end - start);
+        written += TokenBytes + (end - start);
+        i = end;
+    }
+    return written;
+}
+
+bool apply(const std::uint8_t *encoded, std::size_t bytes, std::uint8_t *state, std::size_t stateSize)
+{
+    std::size_t read = 0;
+    std::size_t position = 0;
+    while (read < bytes) {
+        if (bytes - read < TokenBytes)
+            return false;
+        std::uint16_t runs[2];
+        std::memcpy(runs, encoded + read, TokenBytes);
+        read += TokenBytes;
+        position += runs[0];
+        if (runs[1] > bytes - read || position + runs[1] > stateSize)
+            return false;
+        for (std::uint16_t k = 0; k < runs[1]; ++k)
+            state[position + k] ^= encoded[read + k];
+        read += runs[1];
+        position += runs[1];
+    }
+    return true;
+}
+
+} // namespace DeltaCodec
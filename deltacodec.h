@@ -0,0 +1,27 @@
+#ifndef DELTACODEC_H
+#define DELTACODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Run-length coding of the XOR of two equally sized blocks. Blocks of game
+// state barely change from one tick to the next, so the XOR is mostly zeros
+// and encodes to a few tokens:
+//   [uint16 zero bytes][uint16 literal bytes][literal bytes], repeated
+// Used for the rewind history and for network snapshots.
+namespace DeltaCodec {
+
+// Most bytes encode() can write for a delta of size bytes
+std::size_t maxEncodedSize(std::size_t size);
+
+// Encodes delta, already XORed against the base block, into out and returns
+// the bytes written. out may overlap the end of delta; it never catches up.
+std::size_t encode(const std::uint8_t *delta, std::size_t size, std::uint8_t *out);
+
+// XORs an encoded delta into state. Fails without reading or writing out of
+// bounds if the delta doesn't fit a block of stateSize bytes.
+bool apply(const std::uint8_t *encoded, std::size_t bytes, std::uint8_t *state, std::size_t stateSize);
+
+} // namespace DeltaCodec
+
+#endif // DELTACODEC_H
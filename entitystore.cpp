@@ -0,0 +1,44 @@
+#include "entitystore.h"
+#include <initializer_list>
+
+EntityStore::EntityStore()
+{
+    // Reserved up front so ids and pointers stay put for the whole level
+    for (std::vector<float> *array : {&left, &top, &right, &bottom, &velocityX, &minX, &maxX})
+        array->reserve(Capacity);
+    kind.reserve(Capacity);
+    alive.reserve(Capacity);
+}
+
+int EntityStore::add(EntityKind entityKind, const WorldRect &rect)
+{
+    if (isFull())
+        return -1;
+    left.push_back(rect.left);
+    top.push_back(rect.top);
+    right.push_back(rect.right());
+    bottom.push_back(rect.bottom());
+    velocityX.push_back(0);
+    minX.push_back(rect.left);
+    maxX.push_back(rect.left);
+    kind.push_back(entityKind);
+    alive.push_back(1);
+    return size() - 1;
+}
+
+void EntityStore::clear()
+{
+    for (std::vector<float> *array : {&left, &top, &right, &bottom, &velocityX, &minX, &maxX})
+        array->clear();
+    kind.clear();
+    alive.clear();
+}
+
+void EntityStore::moveTo(int id, float x, float y)
+{
+    const size_t i = size_t(id);
+    right[i] = x + (right[i] - left[i]);
+    bottom[i] = y + (bottom[i] - top[i]);
+    left[i] = x;
+    top[i] = y;
+}
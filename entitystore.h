@@ -0,0 +1,54 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "worldrect.h"
+
+enum class EntityKind : std::uint8_t
+{
+    Player,  // driven by input through the swept solver
+    Walker,  // patrols between two x offsets; kills on touch
+    Pickup   // collected on touch
+};
+
+// Every live thing in a level besides the colliders, as structure-of-arrays
+// components with a fixed capacity. The world updates all of them in one
+// pass over these arrays and tests them against the player with the same
+// overlap kernel the colliders use; scene items only mirror them.
+class EntityStore
+{
+public:
+    static constexpr int Capacity = 1024;
+
+    EntityStore();
+
+    // Returns the new entity's id, or -1 when the store is full
+    int add(EntityKind kind, const WorldRect &rect);
+    void clear();
+
+    int size() const { return int(kind.size()); }
+    bool isFull() const { return size() >= Capacity; }
+    WorldRect rect(int id) const
+    {
+        return {left[size_t(id)], top[size_t(id)], right[size_t(id)] - left[size_t(id)],
+                bottom[size_t(id)] - top[size_t(id)]};
+    }
+    void moveTo(int id, float x, float y);
+
+    // Body
+    std::vector<float> left;
+    std::vector<float> top;
+    std::vector<float> right;
+    std::vector<float> bottom;
+    // Motion, px per reference tick
+    std::vector<float> velocityX;
+    // Patrol range for walkers, in absolute x of the left edge
+    std::vector<float> minX;
+    std::vector<float> maxX;
+    std::vector<EntityKind> kind;
+    std::vector<std::uint8_t> alive;
+};
+
+#endif // ENTITYSTORE_H
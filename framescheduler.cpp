@@ -0,0 +1,119 @@
+#include "framescheduler.h"
+#include "profiler.h"
+#include <QEvent>
+#include <QTimer>
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(QObject *parent) : QObject(parent)
+{
+    // Single shot, re-armed against an absolute deadline each frame so
+    // millisecond rounding doesn't accumulate into drift
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &FrameScheduler::runFrame);
+}
+
+void FrameScheduler::setStage(Stage stage, StageFunction function)
+{
+    stages[size_t(stage)] = std::move(function);
+}
+
+void FrameScheduler::start()
+{
+    if (running)
+        return;
+    running = true;
+    clock.start();
+    lastFrameNs = 0;
+    deadlineNs = qint64(targetInterval * 1e9);
+    scheduleNext();
+}
+
+void FrameScheduler::stop()
+{
+    running = false;
+    timer->stop();
+}
+
+void FrameScheduler::setPacing(Pacing pacing, QWindow *target)
+{
+    if (window)
+        window->removeEventFilter(this);
+    window = target;
+
+    currentPacing = (pacing == Pacing::WindowUpdate && window) ? pacing : Pacing::PreciseTimer;
+    if (currentPacing == Pacing::WindowUpdate)
+        window->installEventFilter(this);
+
+    if (running) {
+        timer->stop();
+        deadlineNs = clock.nsecsElapsed() + qint64(targetInterval * 1e9);
+        scheduleNext();
+    }
+}
+
+bool FrameScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    // Run the frame just before Qt paints the window for this update
+    if (watched == window && event->type() == QEvent::UpdateRequest
+        && running && currentPacing == Pacing::WindowUpdate)
+        runFrame();
+    return QObject::eventFilter(watched, event);
+}
+
+void FrameScheduler::scheduleNext()
+{
+    if (!running)
+        return;
+
+    if (currentPacing == Pacing::WindowUpdate && window) {
+        window->requestUpdate();
+        return;
+    }
+
+    const qint64 waitNs = deadlineNs - clock.nsecsElapsed();
+    timer->start(int(std::max<qint64>(0, waitNs / 1000000)));
+}
+
+void FrameScheduler::runFrame()
+{
+    const qint64 now = clock.nsecsElapsed();
+    const qint64 targetNs = qint64(targetInterval * 1e9);
+
+    FrameTiming timing;
+    timing.frame = frameStats.frames++;
+    timing.interval = (now - lastFrameNs) / 1e9;
+    timing.elapsed = timing.interval;
+    lastFrameNs = now;
+
+    frameStats.lastInterval = timing.interval;
+    frameStats.worstInterval = std::max(frameStats.worstInterval, timing.interval);
+    const bool late = timing.interval > 1.5 * targetInterval;
+    if (late) {
+        ++frameStats.lateFrames;
+        if (currentPolicy == Policy::SkipFrames) {
+            frameStats.droppedSeconds += timing.elapsed - targetInterval;
+            timing.elapsed = targetInterval;
+        }
+    }
+
+    // Never render faster to make up for a late frame; the simulation
+    // catches up (or not) according to the policy instead
+    deadlineNs += targetNs;
+    if (deadlineNs <= now)
+        deadlineNs = now + targetNs;
+
+    {
+        static const char *const stageNames[] = {"input", "simulate", "present"};
+        ProfileScope frame(Profiler::FrameEvent);
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (!stages[i])
+                continue;
+            ProfileScope scope(stageNames[i]);
+            stages[i](timing);
+        }
+    }
+
+    scheduleNext();
+}
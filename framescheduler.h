@@ -0,0 +1,99 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QWindow>
+#include <array>
+#include <functional>
+
+class QTimer;
+
+// Drives the whole game from one clock. Every frame runs its stages in a
+// fixed order (input, simulation, present) and Qt paints afterwards, so the
+// player never resolves against platforms from a different frame.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Stage {
+        Input,      // once before the ticks; GameScene latches keys per tick instead
+        Simulate,   // fixed ticks: platforms, then the player
+        Present,    // mirror the world into the scene
+        Count
+    };
+
+    enum class Pacing {
+        PreciseTimer,   // Qt::PreciseTimer aimed at absolute deadlines
+        WindowUpdate    // QWindow::requestUpdate, throttled by the platform
+    };
+
+    enum class Policy {
+        CatchUp,    // simulate all the time that passed (the world caps it)
+        SkipFrames  // drop time beyond one frame; the game slows, never jumps
+    };
+
+    struct FrameTiming
+    {
+        quint64 frame{0};
+        double interval{0};  // seconds since the previous frame
+        double elapsed{0};   // seconds the simulation should advance
+    };
+
+    struct FrameStats
+    {
+        quint64 frames{0};
+        quint64 lateFrames{0};  // took more than 1.5 target intervals
+        double lastInterval{0};
+        double worstInterval{0};
+        double droppedSeconds{0};
+    };
+
+    using StageFunction = std::function<void(const FrameTiming&)>;
+
+    explicit FrameScheduler(QObject *parent = nullptr);
+
+    void setStage(Stage stage, StageFunction function);
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    // WindowUpdate needs the top-level window being painted; falls back to
+    // the timer when there is none yet
+    void setPacing(Pacing pacing, QWindow *window = nullptr);
+    Pacing pacing() const { return currentPacing; }
+
+    void setPolicy(Policy policy) { currentPolicy = policy; }
+    Policy policy() const { return currentPolicy; }
+
+    void setTargetInterval(double seconds) { targetInterval = seconds; }
+    double targetIntervalSeconds() const { return targetInterval; }
+
+    const FrameStats &stats() const { return frameStats; }
+    // Worst interval restarts from here
+    void resetWorstInterval() { frameStats.worstInterval = 0; }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void runFrame();
+    void scheduleNext();
+
+    std::array<StageFunction, size_t(Stage::Count)> stages;
+    QTimer *timer{nullptr};
+    QPointer<QWindow> window;
+    QElapsedTimer clock;
+    qint64 lastFrameNs{0};
+    qint64 deadlineNs{0};
+    double targetInterval{1.0 / 60.0};
+    Pacing currentPacing{Pacing::PreciseTimer};
+    Policy currentPolicy{Policy::CatchUp};
+    FrameStats frameStats;
+    bool running{false};
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,102 @@
+#include "framestreamwriter.h"
+
+FrameStreamWriter::FrameStreamWriter(const QSize &size, int bufferCount)
+    : frameSize(size)
+{
+    // All the frame memory the stream will ever use, allocated up front
+    freeBuffers.reserve(size_t(qMax(2, bufferCount)));
+    for (int i = 0; i < qMax(2, bufferCount); ++i)
+        freeBuffers.emplace_back(size, QImage::Format_RGB32);
+}
+
+FrameStreamWriter::~FrameStreamWriter()
+{
+    close();
+}
+
+bool FrameStreamWriter::open(const QString &path, QString *error)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    stopping = false;
+    worker = std::thread(&FrameStreamWriter::run, this);
+    return true;
+}
+
+bool FrameStreamWriter::close(QString *error)
+{
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join();
+        file.close();
+    }
+    if (!writeError.isEmpty() && error)
+        *error = writeError;
+    return writeError.isEmpty();
+}
+
+QImage FrameStreamWriter::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !freeBuffers.empty(); });
+    QImage frame = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return frame;
+}
+
+void FrameStreamWriter::submit(QImage frame)
+{
+    Q_ASSERT(frame.size() == frameSize && frame.format() == QImage::Format_RGB32);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(frame));
+    }
+    changed.notify_all();
+}
+
+qint64 FrameStreamWriter::framesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+void FrameStreamWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return stopping || !queued.empty(); });
+        if (queued.empty())
+            return;  // stopping, and everything is written
+
+        QImage frame = std::move(queued.front());
+        queued.pop_front();
+        const bool failed = !writeError.isEmpty();
+        lock.unlock();
+
+        // RGB32 rows are always 4 byte aligned, so the bits are one block.
+        // After a failure frames are only recycled, so the renderer never
+        // blocks on a stream that's gone.
+        QString error;
+        if (!failed) {
+            const qint64 bytes = qint64(frame.sizeInBytes());
+            if (file.write(reinterpret_cast<const char *>(frame.constBits()), bytes) != bytes)
+                error = file.errorString();
+        }
+
+        lock.lock();
+        if (!error.isEmpty())
+            writeError = error;
+        else if (!failed)
+            ++written;
+        freeBuffers.push_back(std::move(frame));
+        changed.notify_all();
+    }
+}
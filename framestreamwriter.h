@@ -0,0 +1,53 @@
+#ifndef FRAMESTREAMWRITER_H
+#define FRAMESTREAMWRITER_H
+
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Writes frames as a headerless raw video stream (RGB32, which is bgra in
+// memory on little-endian machines) on its own thread, so rendering never
+// waits on the disk. Frames travel through a fixed pool of buffers: the
+// renderer paints into one it acquired and submits it, and the writer hands
+// it back once written. When every buffer is queued, acquire() blocks, which
+// bounds memory however far ahead rendering runs.
+//
+//   ffmpeg -f rawvideo -pixel_format bgra -video_size WxH -framerate 60 -i frames.raw out.mp4
+class FrameStreamWriter
+{
+public:
+    FrameStreamWriter(const QSize &size, int bufferCount = 4);
+    ~FrameStreamWriter();
+
+    bool open(const QString &path, QString *error = nullptr);
+    // Writes what's queued and stops the thread; false if any write failed
+    bool close(QString *error = nullptr);
+
+    QImage acquire();
+    // Takes back a buffer from acquire(), painted
+    void submit(QImage frame);
+
+    qint64 framesWritten() const;
+
+private:
+    void run();
+
+    QSize frameSize;
+    QFile file;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<QImage> freeBuffers;
+    std::deque<QImage> queued;
+    bool stopping{false};
+    qint64 written{0};
+    QString writeError;
+};
+
+#endif // FRAMESTREAMWRITER_H
@@ -1,252 +1,417 @@
 #include "gamescene.h"
+#include "levelpalette.h"
+#include "profiler.h"
 #include <QGraphicsView>
-#include <QTimer>
 #include <QPainter>
 #include <QLinearGradient>
 #include <QKeyEvent>
 #include <QDebug>
 #include <QPolygonF>
+#include <QGraphicsEllipseItem>
+#include <cmath>
+#include <random>
 
 GameScene::GameScene(QObject *parent) : QGraphicsScene(parent),
-    playerSpeed(5.0),
-    jumpForce(15.0),
-    gravity(0.8),
-    verticalVelocity(0),
-    isJumping(false),
     moveLeft(false),
     moveRight(false),
-    jump(false),
     currentScene(1)
 {
-    // Create player rectangle with gradient brush
-    player = new QGraphicsRectItem(0, 0, 30, 30);
-    QLinearGradient playerGradient(0, 0, 30, 30);
-    playerGradient.setColorAt(0, QColor(0, 150, 255));
-    playerGradient.setColorAt(1, QColor(0, 100, 200));
-    player->setBrush(playerGradient);
-    player->setPen(Qt::NoPen);
+    // The player entity's view; the world does everything else
+    player = new Player(SpriteAtlas::shared(":/anim/anim/kid.json"), QSizeF(world.playerWidth, world.playerHeight));
     addItem(player);
-    player->setPos(0, 0);  // Start somewhere visible on the scene
 
-    // Initialize platform timer for moving platforms
-    platformTimer = new QTimer(this);
-    connect(platformTimer, &QTimer::timeout, this, &GameScene::movePlatforms);
-    platformTimer->start(16); // ~60 FPS
-
-    // Initialize game update timer
-    gameTimer = new QTimer(this);
-    connect(gameTimer, &QTimer::timeout, this, &GameScene::update);
-    gameTimer->start(16); // ~60 FPS
-
-    // Set scene size
-    setSceneRect(0, 0, 800, 600);
+    starItem = new ParticleItem(&stars);
+    starItem->setZValue(-1);
+    addItem(starItem);
+    effectItem = new ParticleItem(&effects);
+    effectItem->setZValue(1);
+    addItem(effectItem);
+
+    // One scheduler drives the game; the world decides how many fixed
+    // ticks each frame is worth. Input is latched per tick inside simulate().
+    scheduler = new FrameScheduler(this);
+    scheduler->setStage(FrameScheduler::Stage::Simulate,
+                        [this](const FrameScheduler::FrameTiming& timing) { simulate(timing.elapsed); });
+    scheduler->setStage(FrameScheduler::Stage::Present,
+                        [this](const FrameScheduler::FrameTiming&) { present(); });
+
+    // One seed per session; the journal keeps it so replays match
+    sessionSeed = std::random_device{}();
+    journal.setSeed(sessionSeed);
+    effectRng.seed(sessionSeed);
+
+    streamer = new LevelStreamer(this);
+    streamer->setSeed(sessionSeed);
+    connect(streamer, &LevelStreamer::levelReady, this, &GameScene::onLevelReady);
 
     // Create initial scene elements
     createScene(currentScene);
+    scheduler->start();
 }
 
 void GameScene::createScene(int sceneNumber)
 {
-    // Clear everything except player
-    for (QGraphicsItem* item : items()) {
-        if (item != player)
-            removeItem(item);
+    std::shared_ptr<PreparedLevel> level;
+    if (!blockingLoads)
+        level = streamer->take(sceneNumber);
+    if (!level) {
+        if (levelArena.objectCount() > 0 && !blockingLoads) {
+            // Keep playing the current level until the worker is done
+            pendingScene = sceneNumber;
+            streamer->preload(sceneNumber, world.tickSeconds());
+            return;
+        }
+        // Nothing on screen yet, so there's no frame to protect
+        level = LevelStreamer::prepare(sceneNumber, world.tickSeconds(), sessionSeed);
     }
+    showLevel(*level);
+}
 
-    // Background with gradient
-    QGraphicsRectItem* background = new QGraphicsRectItem(0, 0, 800, 600);
-    QLinearGradient bgGradient(0, 0, 0, 600);
-    bgGradient.setColorAt(0, QColor(30, 30, 60));
-    bgGradient.setColorAt(1, QColor(10, 10, 30));
-    background->setBrush(bgGradient);
-    background->setPen(Qt::NoPen);
-    addItem(background);
-    background->setZValue(-1);
-
-    // Add stars
-    for (int i = 0; i < 100; ++i) {
-        int size = 1 + rand() % 3;
-        QGraphicsEllipseItem* star = new QGraphicsEllipseItem(0, 0, size, size);
-        star->setPos(rand() % 800, rand() % 300);
-        star->setBrush(QColor(255, 255, 255, 150 + rand() % 105));
-        star->setPen(Qt::NoPen);
-        addItem(star);
-        star->setZValue(-0.5);
+void GameScene::onLevelReady(int levelNumber)
+{
+    if (levelNumber == pendingScene) {
+        pendingScene = 0;
+        createScene(levelNumber);
     }
-
-    createPlatforms(sceneNumber);
-    createSpikes(sceneNumber);
 }
 
-void GameScene::createPlatforms(int sceneNumber)
+void GameScene::showLevel(PreparedLevel& level)
 {
-    // Remove existing moving platforms if any
-    if (movingPlatform) {
-        removeItem(movingPlatform);
-        delete movingPlatform;
-        movingPlatform = nullptr;
+    if (!level.isValid()) {
+        qWarning() << "Cannot load level" << level.number << ":" << level.error;
+        return;
     }
-    if (movingPlatform2) {
-        removeItem(movingPlatform2);
-        delete movingPlatform2;
-        movingPlatform2 = nullptr;
+
+    // Free the outgoing level in one go; the player item is kept
+    levelArena.reset();
+    movingPlatforms.clear();
+    entityItems.clear();
+    chunkLayers.clear();
+    freeLayers.clear();
+
+    if (journal.hasOpenSegment())
+        journal.endSegment(world.stateHash());
+    world = std::move(level.world);
+    world.setInput(moveLeft, moveRight);
+    world.setRewinding(rewindHeld);
+    world.setJournal(&journal);
+    journal.beginSegment(level.number, 1.0 / world.tickSeconds());
+    currentScene = level.number;
+
+    // Set scene size
+    setSceneRect(0, 0, world.width, world.height);
+
+    // The baked sky replaces the background layer; views caching it redraw once
+    backgroundPixmap = QPixmap::fromImage(level.background);
+    backgroundFill = QColor::fromRgba(level.decoration.skyBottom);
+    invalidate(sceneRect(), QGraphicsScene::BackgroundLayer);
+    dirtyAll = true;
+
+    effects.clear();
+    createStars(level);
+    starItem->setBounds(sceneRect());
+    effectItem->setBounds(sceneRect());
+    particleTime = simulationTime;
+
+    // Static items come and go with the camera; the rest are few and move
+    chunks.build(world.colliders(), world.width, world.height);
+    chunkLayers.assign(size_t(chunks.chunkCount()), nullptr);
+    createMovers();
+    createEntities();
+    syncItems();
+    updateCamera(true);
+
+    // Build the next level while this one plays
+    if (!blockingLoads)
+        streamer->preload(LevelStreamer::nextLevel(currentScene), world.tickSeconds());
+}
+
+GameScene::LevelMemory GameScene::levelMemory() const
+{
+    LevelMemory memory;
+    memory.objects = levelArena.objectCount();
+    memory.arenaBytes = levelArena.bytesUsed();
+    memory.arenaReserved = levelArena.bytesReserved();
+    memory.residentBytes = processResidentBytes();
+    memory.chunks = chunks.chunkCount();
+    memory.activeChunks = chunks.activeChunks();
+    return memory;
+}
+
+bool GameScene::saveJournal(const QString& path, QString* error) const
+{
+    // The level being played is still open; close it on a copy
+    InputJournal session = journal;
+    session.endSegment(world.stateHash());
+    std::string message;
+    if (session.save(path.toStdString(), &message))
+        return true;
+    if (error)
+        *error = QString::fromStdString(message);
+    return false;
+}
+
+void GameScene::restart(int levelNumber, std::uint32_t seed)
+{
+    sessionSeed = seed;
+    effectRng.seed(seed);
+    streamer->setSeed(seed);
+    journal.clear();
+    journal.setSeed(seed);
+    pendingScene = 0;
+    moveLeft = false;
+    moveRight = false;
+    jumpRequested = false;
+    rewindHeld = false;
+    keyQueue.clear();
+    consumedKeys.clear();
+    simulationTime = 0;
+    showLevel(*LevelStreamer::prepare(levelNumber, world.tickSeconds(), seed));
+}
+
+void GameScene::setInput(const PlayerInput& input)
+{
+    moveLeft = input.moveLeft;
+    moveRight = input.moveRight;
+    jumpRequested = input.jump;
+    jumpPhase = input.jumpPhase;
+    rewindHeld = input.rewind;
+}
+
+void GameScene::step(double elapsedSeconds)
+{
+    simulate(elapsedSeconds);
+    present();
+}
+
+void GameScene::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    // The baked tile repeats along the level; below it is plain sky
+    const QRectF sky(0, 0, world.width, backgroundPixmap.height());
+    const QRectF baked = rect.intersected(sky);
+    if (baked != rect)
+        painter->fillRect(rect, backgroundFill);
+    if (!baked.isEmpty() && !backgroundPixmap.isNull())
+        painter->drawTiledPixmap(baked, backgroundPixmap,
+                                 QPointF(std::fmod(baked.left(), qreal(backgroundPixmap.width())), baked.top()));
+}
+
+void GameScene::createMovers()
+{
+    // Moving platforms are positioned from the world every frame
+    const LevelPalette& palette = LevelPalette::instance();
+    const ColliderStore& colliders = world.colliders();
+    for (const MovingPlatform& platform : world.movingPlatforms()) {
+        const WorldRect r = colliders.rect(platform.collider);
+        auto* item = createLevelItem<QGraphicsRectItem>(platform.originLeft, platform.originTop, r.width, r.height);
+        item->setPos(platform.offsetX, platform.offsetY);
+        item->setBrush(palette.mover);
+        item->setPen(palette.outline);
+        movingPlatforms.push_back(item);
     }
+}
 
-    // Ground platform
-    QGraphicsRectItem* ground = new QGraphicsRectItem(350, 500, 800, 50);
-    QLinearGradient groundGrad(0, 550, 0, 600);
-    groundGrad.setColorAt(0, QColor(80, 50, 30));
-    groundGrad.setColorAt(1, QColor(50, 30, 20));
-    ground->setBrush(groundGrad);
-    ground->setPen(Qt::NoPen);
-    addItem(ground);
-
-    if (sceneNumber == 1) {
-        // Static platforms
-        QGraphicsRectItem* platform4 = new QGraphicsRectItem(500, 200, 225, 65);
-        QLinearGradient platform4Gradient(600, 350, 600, 370);
-        platform4Gradient.setColorAt(0, QColor(120, 80, 50));
-        platform4Gradient.setColorAt(1, QColor(90, 60, 40));
-        platform4->setBrush(platform4Gradient);
-        platform4->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(platform4);
-
-        QGraphicsRectItem* platform5 = new QGraphicsRectItem(125, 250, 246, 40);
-        QLinearGradient platform5Gradient(200, 250, 200, 270);
-        platform5Gradient.setColorAt(0, QColor(120, 80, 50));
-        platform5Gradient.setColorAt(1, QColor(90, 60, 40));
-        platform5->setBrush(platform5Gradient);
-        platform5->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(platform5);
-
-        QGraphicsRectItem* platform1 = new QGraphicsRectItem(0, 100, 350, 20);
-        QLinearGradient platform1Gradient(100, 400, 100, 420);
-        platform1Gradient.setColorAt(0, QColor(120, 80, 50));
-        platform1Gradient.setColorAt(1, QColor(90, 60, 40));
-        platform1->setBrush(platform1Gradient);
-        platform1->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(platform1);
-
-        QGraphicsRectItem* platform10 = new QGraphicsRectItem(0, 400, 200, 20);
-        QLinearGradient platform10Gradient(100, 400, 100, 420);
-        platform10Gradient.setColorAt(0, QColor(120, 80, 50));
-        platform10Gradient.setColorAt(1, QColor(90, 60, 40));
-        platform10->setBrush(platform10Gradient);
-        platform10->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(platform10);
-
-        QGraphicsRectItem* platform2 = new QGraphicsRectItem(300, 400, 560, 20);
-        QLinearGradient platform2Gradient(300, 350, 300, 370);
-        platform2Gradient.setColorAt(0, QColor(120, 80, 50));
-        platform2Gradient.setColorAt(1, QColor(90, 60, 40));
-        platform2->setBrush(platform2Gradient);
-        platform2->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(platform2);
-
-        // Moving platform 1 (horizontal sliding)
-        movingPlatform = new QGraphicsRectItem(350, 100, 80, 20);
-        movingPlatform->setBrush(QColor(150, 100, 60));
-        movingPlatform->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(movingPlatform);
-        movingPlatformDirection = 1;
-
-        // Moving platform 2
-        movingPlatform2 = new QGraphicsRectItem(0, 500, 80, 20);
-        movingPlatform2->setBrush(QColor(150, 100, 60));
-        movingPlatform2->setPen(QPen(QColor(70, 50, 30), 1));
-        addItem(movingPlatform2);
-        movingPlatform2Direction = 1;
+void GameScene::showChunk(int chunk)
+{
+    TileLayerItem* layer = nullptr;
+    if (!freeLayers.empty()) {
+        layer = freeLayers.back();
+        freeLayers.pop_back();
+    } else {
+        layer = createLevelItem<TileLayerItem>();
     }
+    layer->setTiles(chunks.chunkRect(chunk), world.colliders(), chunks.colliders(chunk));
+    layer->show();
+    chunkLayers[size_t(chunk)] = layer;
+    markDirty(layer->sceneBoundingRect());
 }
 
-void GameScene::createSpikes(int sceneNumber)
-{
-    switch (sceneNumber) {
-    case 1: {
-        // the platform full of spikes
-        for (int i = 0; i < 12; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(125 + i * 20, 230);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
-        }
+void GameScene::hideChunk(int chunk)
+{
+    TileLayerItem* layer = chunkLayers[size_t(chunk)];
+    if (!layer)
+        return;
+    chunkLayers[size_t(chunk)] = nullptr;
+    markDirty(layer->sceneBoundingRect());
+    layer->hide();
+    freeLayers.push_back(layer);
+}
 
-        // spikes on the edges of the second platform
-        for (int i = 0; i < 3; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(675 + i * 20, 180);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
-        }
+void GameScene::setViewportSize(const QSizeF& size)
+{
+    if (size == cameraRect.size() || size.isEmpty())
+        return;
+    cameraRect.setSize(size);
+    updateCamera(true);
+}
 
-        for (int i = 0; i < 3; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(500 + i * 20, 180);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
-        }
+void GameScene::updateCamera(bool snap)
+{
+    // Follow the player, who can move about the middle of the view without
+    // it scrolling. Levels smaller than the view stay centered in it.
+    const QPointF target = player->pos() + QPointF(world.playerWidth / 2, world.playerHeight / 2);
+    const QSizeF view = cameraRect.size();
+    QPointF center = snap ? target : cameraRect.center();
+    center.setX(qBound(target.x() - view.width() / 6, center.x(), target.x() + view.width() / 6));
+    center.setY(qBound(target.y() - view.height() / 4, center.y(), target.y() + view.height() / 4));
+
+    auto clampAxis = [](qreal c, qreal viewSize, qreal levelSize) {
+        return viewSize >= levelSize ? levelSize / 2 : qBound(viewSize / 2, c, levelSize - viewSize / 2);
+    };
+    center.setX(clampAxis(center.x(), view.width(), world.width));
+    center.setY(clampAxis(center.y(), view.height(), world.height));
+
+    // Whole pixels, so scrolling never resamples the scene
+    const QRectF next(QPointF(std::round(center.x() - view.width() / 2), std::round(center.y() - view.height() / 2)),
+                      view);
+    if (next == cameraRect && !snap)
+        return;
+    cameraRect = next;
+    dirtyAll = true;
+    updateChunks();
+}
 
-        // Ground spikes
-        for (int i = 0; i < 3; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(0 + i * 20, 380);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
-        }
+void GameScene::updateChunks()
+{
+    chunksEntered.clear();
+    chunksLeft.clear();
+    chunks.update({float(cameraRect.left()), float(cameraRect.top()), float(cameraRect.width()),
+                   float(cameraRect.height())},
+                  chunksEntered, chunksLeft);
+    // Hidden first, so their layers can be reused straight away
+    for (int chunk : chunksLeft)
+        hideChunk(chunk);
+    for (int chunk : chunksEntered)
+        showChunk(chunk);
+}
 
-        for (int i = 0; i < 3; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(350 + i * 20, 380);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
-        }
+void GameScene::createEntities()
+{
+    const LevelPalette& palette = LevelPalette::instance();
+    const EntityStore& entities = world.entities();
+    entityItems.assign(size_t(entities.size()), nullptr);
+    for (int i = 0; i < entities.size(); ++i) {
+        const WorldRect r = entities.rect(i);
+        QAbstractGraphicsShapeItem* item = nullptr;
+        if (entities.kind[size_t(i)] == EntityKind::Pickup)
+            item = createLevelItem<QGraphicsEllipseItem>(0, 0, r.width, r.height);
+        else if (entities.kind[size_t(i)] == EntityKind::Walker)
+            item = createLevelItem<QGraphicsRectItem>(0, 0, r.width, r.height);
+        if (!item)
+            continue;
+        item->setPos(r.left, r.top);
+        item->setBrush(entities.kind[size_t(i)] == EntityKind::Pickup ? palette.coin : palette.walker);
+        item->setPen(palette.outline);
+        item->setVisible(entities.alive[size_t(i)]);
+        entityItems[size_t(i)] = item;
+    }
+}
+
+void GameScene::createStars(const PreparedLevel& level)
+{
+    // As many per sky tile as the level asks for, all along the level
+    stars.clear();
+    std::mt19937 rng(level.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const quint64 tiles = quint64(std::ceil(world.width / LevelStreamer::BackgroundTileWidth));
+    const quint64 count = quint64(level.decoration.starCount) * qMax<quint64>(1, tiles);
+    const quint32 width = quint32(qMax(1.0f, world.width));
+    const quint32 height = quint32(qMax(1.0f, level.decoration.starMaxY));
+    for (quint64 i = 0; i < count; ++i) {
+        const float size = float(1 + rng() % 3);
+        const float x = float(rng() % width);
+        const float y = float(rng() % height);
+        const float phase = unit(rng) * 6.2831853f;
+        const float rate = 1.0f + 3.0f * unit(rng);
+        if (!stars.addStar(x, y, size, phase, rate))
+            break;
+    }
+}
 
-        for (int i = 0; i < 3; i++) {
-            QGraphicsPolygonItem* spike = new QGraphicsPolygonItem();
-            QPolygonF triangle;
-            triangle << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
-            spike->setPolygon(triangle);
-            spike->setPos(750 + i * 20, 380);
-            spike->setBrush(QColor(200, 0, 0));
-            spike->setPen(Qt::NoPen);
-            addItem(spike);
+void GameScene::spawnEffects(unsigned events)
+{
+    constexpr float up = -1.5707963f;
+    const float halfWidth = world.playerWidth / 2;
+
+    if (events & World::PlayerDied) {
+        const DeathRecord& death = world.lastDeath();
+        // Falls happen off screen; spikes get a burst where they hit
+        if (death.cause == DeathCause::Hazard) {
+            ParticlePool::Burst sparks;
+            sparks.kind = ParticleKind::Spark;
+            sparks.x = death.x + halfWidth;
+            sparks.y = death.y + world.playerHeight / 2;
+            sparks.count = 400;
+            sparks.minSpeed = 60;
+            sparks.maxSpeed = 320;
+            sparks.gravity = 900;
+            sparks.minLife = 0.4f;
+            sparks.maxLife = 1.0f;
+            sparks.size = 3;
+            effects.spawn(sparks, effectRng);
         }
-        break;
+
+        ParticlePool::Burst glow;
+        glow.kind = ParticleKind::Glow;
+        glow.x = world.spawnX + halfWidth;
+        glow.y = world.spawnY + world.playerHeight;
+        glow.count = 120;
+        glow.angle = up;
+        glow.spread = 3.1415927f;
+        glow.minSpeed = 40;
+        glow.maxSpeed = 160;
+        glow.gravity = -60;
+        glow.minLife = 0.5f;
+        glow.maxLife = 1.0f;
+        effects.spawn(glow, effectRng);
+    } else if (events & World::PlayerLanded) {
+        const PlayerState& p = world.player();
+        ParticlePool::Burst dust;
+        dust.kind = ParticleKind::Dust;
+        dust.x = p.x + halfWidth;
+        dust.y = p.y + world.playerHeight;
+        dust.count = 24;
+        dust.angle = up;
+        dust.spread = 2.8f;
+        dust.minSpeed = 30;
+        dust.maxSpeed = 110;
+        dust.gravity = 260;
+        dust.minLife = 0.25f;
+        dust.maxLife = 0.55f;
+        effects.spawn(dust, effectRng);
     }
+}
+
+void GameScene::updateParticles()
+{
+    // On the same clock the player animates on, so offscreen renders match.
+    // A stall just skips ahead rather than fast-forwarding the bursts.
+    const double now = simulationTime + world.interpolationAlpha() * world.tickSeconds();
+    const float seconds = float(qBound(0.0, now - particleTime, 0.1));
+    particleTime = now;
+    stars.update(seconds);
+    effects.update(seconds);
+
+    for (const ParticlePool* pool : {&stars, &effects}) {
+        if (pool->hasMovingBounds()) {
+            const WorldRect& b = pool->movingBounds();
+            markDirty(QRectF(b.left, b.top, b.width, b.height));
+        }
+        for (const WorldRect& r : pool->changedStill()) {
+            const QRectF rect(r.left, r.top, r.width, r.height);
+            if (rect.intersects(cameraRect))
+                markDirty(rect);
+        }
     }
 }
 
 GameScene::~GameScene()
 {
-    // Stop timers
-    if (platformTimer) {
-        platformTimer->stop();
-        delete platformTimer;
-    }
-    if (gameTimer) {
-        gameTimer->stop();
-        delete gameTimer;
-    }
+    // No more frames against a half-destroyed scene
+    scheduler->stop();
+
+    // Level items live in the arena and must be destroyed by it
+    levelArena.reset();
 
     // Clear all items
     clear();
@@ -255,260 +420,183 @@ GameScene::~GameScene()
 void GameScene::keyPressEvent(QKeyEvent *event)
 {
     if (event->isAutoRepeat()) return;
-
-    switch (event->key()) {
-    case Qt::Key_Left:
-        moveLeft = true;
-        break;
-    case Qt::Key_Right:
-        moveRight = true;
-        break;
-    case Qt::Key_Space:
-        if (!isJumping && player->y() >= 0) {
-            verticalVelocity = -jumpForce;
-            isJumping = true;
-        }
-        break;
-    }
+    queueKey(event, true);
 }
 
 void GameScene::keyReleaseEvent(QKeyEvent *event)
 {
     if (event->isAutoRepeat()) return;
+    queueKey(event, false);
+}
 
+void GameScene::queueKey(QKeyEvent* event, bool pressed)
+{
     switch (event->key()) {
     case Qt::Key_Left:
-        moveLeft = false;
-        break;
     case Qt::Key_Right:
-        moveRight = false;
+    case Qt::Key_Backspace:
         break;
+    case Qt::Key_Space:
+        if (pressed)
+            break;
+        return;
+    default:
+        return;
     }
+    // Stamped on arrival; QKeyEvent::timestamp() is on a clock of its own
+    keyQueue.push_back(KeyEvent{Profiler::nowNs(), event->key(), pressed});
 }
 
-void GameScene::movePlatforms()
+void GameScene::latchInput(std::uint64_t tickEndNs)
 {
-    // Move movingPlatform left and right between bounds
-    if (movingPlatform) {
-        qreal x = movingPlatform->x();
-        if (x > 350) movingPlatformDirection = -1;
-        else if (x < 0) movingPlatformDirection = 1;
-        movingPlatform->setX(x + movingPlatformDirection * 2);
-    }
-
-    // Move movingPlatform2 up and down between bounds
-    if (movingPlatform2) {
-        qreal x = movingPlatform2->x();
-        if (x > 250) movingPlatform2Direction = -1;
-        else if (x < 0) movingPlatform2Direction = 1;
-        movingPlatform2->setX(x + movingPlatform2Direction * 1.5);
+    const std::uint64_t tickNs = std::uint64_t(world.tickSeconds() * 1e9);
+    const std::uint64_t tickStartNs = tickEndNs > tickNs ? tickEndNs - tickNs : 0;
+    size_t taken = 0;
+    for (; taken < keyQueue.size() && keyQueue[taken].ns < tickEndNs; ++taken) {
+        const KeyEvent& key = keyQueue[taken];
+        consumedKeys.push_back(key.ns);
+        switch (key.key) {
+        case Qt::Key_Left:
+            moveLeft = key.pressed;
+            break;
+        case Qt::Key_Right:
+            moveRight = key.pressed;
+            break;
+        case Qt::Key_Backspace:
+            rewindHeld = key.pressed;
+            break;
+        case Qt::Key_Space:
+            // The first press in a tick decides how much of it the jump gets
+            if (!jumpRequested) {
+                jumpRequested = true;
+                const std::uint64_t into = key.ns > tickStartNs ? key.ns - tickStartNs : 0;
+                jumpPhase = int(into * PlayerInput::JumpPhases / std::max<std::uint64_t>(tickNs, 1));
+            }
+            break;
+        }
     }
+    keyQueue.erase(keyQueue.begin(), keyQueue.begin() + std::ptrdiff_t(taken));
+
+    world.setInput(moveLeft, moveRight);
+    world.setRewinding(rewindHeld);
+    if (jumpRequested)
+        world.requestJump(jumpPhase);
+    jumpRequested = false;
+    jumpPhase = 0;
 }
 
-void GameScene::resetPlayer() {
-    // Reset player to starting position
-    player->setPos(0, 0);
-
-    // Reset movement variables
-    verticalVelocity = 0;
-    isJumping = false;
-    moveLeft = false;
-    moveRight = false;
-
-    qDebug() << "Player died and respawned!";
-}
-
-void GameScene::update() {
-    // Horizontal movement with boundary checks
-    if (moveLeft) {
-        player->setX(qMax(0.0, player->x() - playerSpeed));
+void GameScene::simulate(double elapsedSeconds)
+{
+    const std::uint64_t now = Profiler::nowNs();
+    const int steps = world.accumulate(elapsedSeconds);
+    simulationTime += steps * world.tickSeconds();
+
+    // The ticks due end where the leftover time the next frame interpolates
+    // over begins; each one takes the keys that arrived before its end
+    const std::uint64_t tickNs = std::uint64_t(world.tickSeconds() * 1e9);
+    const std::uint64_t behind = std::uint64_t(world.interpolationAlpha() * tickNs) + std::uint64_t(steps - 1) * tickNs;
+    std::uint64_t tickEnd = now > behind ? now - behind : 0;
+    unsigned events = World::NoEvent;
+    for (int i = 0; i < steps; ++i, tickEnd += tickNs) {
+        latchInput(tickEnd);
+        world.step();
+        const unsigned tickEvents = world.takeEvents();
+        if (tickEvents & World::PlayerDied) {
+            // Dying resets the held keys as well
+            moveLeft = false;
+            moveRight = false;
+        }
+        events |= tickEvents;
     }
-    if (moveRight) {
-        player->setX(qMin(sceneRect().width() - player->rect().width(), player->x() + playerSpeed));
+    if (steps > 0) {
+        spawnEffects(events);
+        if ((events & World::PlayerExited) && !pendingScene)
+            createScene(LevelStreamer::nextLevel(currentScene));
     }
+}
 
-    // Apply gravity
-    verticalVelocity += gravity;
-
-    // Proposed new Y position
-    qreal newY = player->y() + verticalVelocity;
+void GameScene::present()
+{
+    syncItems();
+    updateParticles();
+    updateCamera(false);
+    emit frameAdvanced();
+}
 
-    // Prevent player from going above the top of the screen
-    if (newY < 0) {
-        newY = 0;
-        verticalVelocity = 0;
+void GameScene::framePainted()
+{
+    // Simulate and present run back to back, so every key a tick has taken
+    // is in the frame that was just painted
+    const std::uint64_t now = Profiler::nowNs();
+    for (std::uint64_t arrived : consumedKeys) {
+        latency.add(now - arrived);
+        Profiler::instance().count(Profiler::InputLatencyCounter, std::int64_t((now - arrived) / 1000));
     }
+    consumedKeys.clear();
+}
 
-    QRectF playerRect = player->mapRectToScene(player->boundingRect());
-
-
-    qreal finalY = newY;
-
-    // Check collisions only if falling or moving vertically
-    if (verticalVelocity >= 0) {
-        for (QGraphicsItem* item : items()) {
-            if (item == player || !item->isVisible()) continue;
-
-            // Check for platform collisions
-            QGraphicsRectItem* platform = dynamic_cast<QGraphicsRectItem*>(item);
-            if (platform) {
-                QRectF platformRect = platform->mapRectToScene(platform->boundingRect());
-
-                bool horizontalOverlap = (playerRect.right() > platformRect.left()) &&
-                                         (playerRect.left() < platformRect.right());
-
-                if (horizontalOverlap) {
-                    qreal playerBottom = playerRect.bottom();
-                    qreal playerTop = playerRect.top();
-                    qreal platformTop = platformRect.top();
-                    qreal platformBottom = platformRect.bottom();
-
-                    if (playerBottom <= platformTop && (playerBottom + verticalVelocity) >= platformTop) {
-
-                        // landed = true;
-                        finalY = platformTop - player->boundingRect().height();
-                        verticalVelocity = 0;
-                        isJumping = false;
-
-                        // platform->setBrush(QBrush(Qt::red));
-
-                        break;
-                    }
-
-                    // if (playerTop <= platformBottom && playerTop + verticalVelocity >= platformBottom) {
-                    //     if (verticalVelocity > 0) { // Le joueur monte (heurt depuis le bas)
-                    //         qDebug() << "Collision avec le bas de la plateforme !";
-                    //         qDebug() << "playerTop: " << playerTop << "player bottom : " << playerBottom;
-                    //         qDebug() << "platformBottom: " << platformBottom;
-
-                    //         // Arrêter le mouvement vers le haut
-                    //         verticalVelocity = 0;
+void GameScene::setTrackDirtyRects(bool track)
+{
+    trackDirty = track;
+    dirtyRects.clear();
+    dirtyAll = true;
+}
 
-                    //         // Repositionner le joueur juste sous la plateforme
-                    //         finalY = platformBottom;
+void GameScene::markDirty(const QRectF& rect)
+{
+    if (trackDirty)
+        dirtyRects.append(rect);
+}
 
-                    //         // Optionnel : changer la couleur de la plateforme
-                    //         platform->setBrush(Qt::blue); // Différente couleur pour heurt par le bas
+bool GameScene::takeDirtyRects(QVector<QRectF>& out)
+{
+    out += dirtyRects;
+    dirtyRects.clear();
+    const bool all = dirtyAll;
+    dirtyAll = false;
+    return all;
+}
 
-                    //         // Vous pourriez aussi ajouter un effet ou un son ici
-                    //     }
-                    // }
-                }
-            }
+void GameScene::moveItem(QGraphicsItem* item, const QPointF& pos)
+{
+    if (item->pos() == pos)
+        return;
+    // Both where it was and where it is now need repainting
+    const QRectF before = item->sceneBoundingRect();
+    item->setPos(pos);
+    markDirty(before.united(item->sceneBoundingRect()));
+}
 
-            // Check for spike collisions
-            if (item->type() == QGraphicsPolygonItem::Type) {
-                QRectF spikeRect = item->mapRectToScene(item->boundingRect());
-                if (playerRect.intersects(spikeRect)) {
-                    resetPlayer();
-                    return;
-                }
+void GameScene::syncItems()
+{
+    // Render between the last two ticks so motion stays smooth when the
+    // frame rate and the tick rate don't line up
+    const WorldSnapshot& from = world.previousSnapshot();
+    const WorldSnapshot& to = world.currentSnapshot();
+    const qreal alpha = world.interpolationAlpha();
+    auto lerp = [alpha](qreal a, qreal b) { return a + (b - a) * alpha; };
+
+    moveItem(player, QPointF(lerp(from.playerX, to.playerX), lerp(from.playerY, to.playerY)));
+    if (player->sync(world.player(), world.input(), simulationTime + alpha * world.tickSeconds()))
+        markDirty(player->sceneBoundingRect());
+
+    for (size_t i = 0; i < movingPlatforms.size() && i < to.platformOffsetsX.size() && i < from.platformOffsetsX.size(); ++i)
+        moveItem(movingPlatforms[i], QPointF(lerp(from.platformOffsetsX[i], to.platformOffsetsX[i]),
+                                             lerp(from.platformOffsetsY[i], to.platformOffsetsY[i])));
+
+    const EntityStore& entities = world.entities();
+    for (size_t i = 0; i < entityItems.size() && i < to.entityLefts.size() && i < from.entityLefts.size(); ++i) {
+        QGraphicsItem* item = entityItems[i];
+        if (!item)
+            continue;
+        if (!entities.alive[i]) {
+            if (item->isVisible()) {
+                markDirty(item->sceneBoundingRect());
+                item->hide();
             }
+            continue;
         }
+        if (entities.kind[i] == EntityKind::Walker)
+            moveItem(item, QPointF(lerp(from.entityLefts[i], to.entityLefts[i]), item->y()));
     }
-
-    // Check if player fell off the bottom of the screen
-    if (newY > sceneRect().height()) {
-        resetPlayer();
-        return;
-    }
-
-    // Update player vertical position
-    player->setY(finalY);
-}
-
-
-// void GameScene::update() {
-//     // Mouvement horizontal
-//     if (moveLeft) {
-//         player->setX(qMax(0.0, player->x() - playerSpeed));
-//     }
-//     if (moveRight) {
-//         player->setX(qMin(sceneRect().width() - player->rect().width(), player->x() + playerSpeed));
-//     }
-
-//     // Application de la gravité
-//     verticalVelocity = qMin(verticalVelocity + gravity, 20.0);
-//     qreal newY = player->y() + verticalVelocity;
-//     QRectF playerRect = player->mapRectToScene(player->boundingRect());
-//     qreal finalY = newY;
-
-//     // Constantes
-//     const qreal LANDING_TOLERANCE = 1.0;  // Tolérance pour l'atterrissage
-//     const qreal SIDE_TOLERANCE = 0.5;     // Tolérance pour les côtés
-//     const qreal RESTITUTION = 0.4;
-
-//     bool onGround = false;
-
-//     // Détection des collisions
-//     for (QGraphicsItem* item : items()) {
-//         if (item == player || !item->isVisible()) continue;
-
-//         // Collision avec plateforme
-//         if (QGraphicsRectItem* platform = dynamic_cast<QGraphicsRectItem*>(item)) {
-//             QRectF platformRect = platform->mapRectToScene(platform->boundingRect());
-
-//             // Vérification du chevauchement
-//             if (playerRect.intersects(platformRect)) {
-//                 qreal playerBottom = playerRect.bottom();
-//                 qreal platformTop = platformRect.top();
-
-//                 // Collision par le haut (atterrissage)
-//                 if (verticalVelocity >= 0 &&
-//                     playerBottom <= platformTop + LANDING_TOLERANCE) {
-
-//                     finalY = platformTop - player->boundingRect().height();
-//                     verticalVelocity = 0;
-//                     isJumping = false;
-//                     onGround = true;
-//                     platform->setBrush(Qt::red);
-//                     break;
-//                 }
-
-//                 // Collision par le bas
-//                 if (verticalVelocity < 0 &&
-//                     player->y() <= platformRect.bottom()) {
-//                     verticalVelocity = -verticalVelocity * RESTITUTION;
-//                     platform->setBrush(Qt::blue);
-//                 }
-
-//                 // Collisions latérales
-//                 if (!onGround) {
-//                     // Gauche
-//                     if (playerRect.right() > platformRect.left() &&
-//                         playerRect.left() < platformRect.left()) {
-//                         player->setX(platformRect.left() - player->boundingRect().width());
-//                     }
-//                     // Droite
-//                     else if (playerRect.left() < platformRect.right() &&
-//                              playerRect.right() > platformRect.right()) {
-//                         player->setX(platformRect.right());
-//                     }
-//                 }
-//             }
-//         }
-
-//         // Collision avec pics
-//         if (item->type() == QGraphicsPolygonItem::Type) {
-//             QRectF spikeRect = item->mapRectToScene(item->boundingRect());
-//             if (playerRect.intersects(spikeRect)) {
-//                 resetPlayer();
-//                 return;
-//             }
-//         }
-//     }
-
-//     // Limites de l'écran
-//     if (newY < 0) {
-//         finalY = 0;
-//         verticalVelocity = 0;
-//     }
-
-//     if (newY > sceneRect().height()) {
-//         resetPlayer();
-//         return;
-//     }
-
-//     // Mise à jour position
-//     player->setY(finalY);
-// }
+}
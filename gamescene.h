@@ -3,9 +3,23 @@
 
 #include <QGraphicsScene>
 #include <QGraphicsRectItem>
-#include <QTimer>
 #include <QKeyEvent>
 #include <QGraphicsPolygonItem>
+#include <QPixmap>
+#include <QVector>
+#include <random>
+#include <vector>
+#include "chunkmap.h"
+#include "world.h"
+#include "levelstreamer.h"
+#include "levelarena.h"
+#include "framescheduler.h"
+#include "inputjournal.h"
+#include "latencyhistogram.h"
+#include "particleitem.h"
+#include "particlepool.h"
+#include "player.h"
+#include "tilelayeritem.h"
 
 class GameScene : public QGraphicsScene
 {
@@ -15,40 +29,163 @@ public:
     explicit GameScene(QObject *parent = nullptr);
     ~GameScene();
 
+    struct LevelMemory
+    {
+        size_t objects{0};
+        size_t arenaBytes{0};
+        size_t arenaReserved{0};
+        size_t residentBytes{0};
+        int chunks{0};
+        int activeChunks{0};
+    };
+    // Lets us check that reloading levels keeps memory flat
+    LevelMemory levelMemory() const;
+
+    // Scene rects whose contents changed since the last call. Returns true
+    // when everything must be repainted, e.g. after a level switch. Rects
+    // are only collected once a view has said it takes them, so scenes
+    // nobody drains (offscreen rendering, benchmarks) don't pile them up.
+    void setTrackDirtyRects(bool track);
+    bool takeDirtyRects(QVector<QRectF>& out);
+
+    FrameScheduler* frameScheduler() const { return scheduler; }
+
+    // Part of the level on screen. It follows the player and stays inside
+    // the level; views show this rect and set its size from their viewport.
+    QRectF camera() const { return cameraRect; }
+    void setViewportSize(const QSizeF& size);
+
+    // Writes every tick of input since the game started, for --replay
+    bool saveJournal(const QString& path, QString* error = nullptr) const;
+
+    // Driving the scene without its scheduler, for offscreen rendering.
+    // restart() begins a fresh session on a level with a known seed, so the
+    // frames are reproducible; step() runs one frame's stages.
+    void restart(int levelNumber, std::uint32_t seed);
+    void setInput(const PlayerInput& input);
+    void step(double elapsedSeconds);
+    // Build levels on this thread when switching instead of streaming them,
+    // so a level change never waits for the event loop
+    void setBlockingLoads(bool blocking) { blockingLoads = blocking; }
+
+    // Time from a key event arriving to the end of the first paint that
+    // shows the tick it went into, for every key event the world consumed.
+    // The view painting the scene reports each finished paint.
+    void framePainted();
+    const LatencyHistogram& inputLatency() const { return latency; }
+    void resetInputLatency() { latency.reset(); }
+
+signals:
+    void frameAdvanced();
+
 protected:
     void keyPressEvent(QKeyEvent *event) override;
     void keyReleaseEvent(QKeyEvent *event) override;
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
 
 private slots:
-    void update();  // Game loop function
-    void resetPlayer();
-    void movePlatforms();
+    void onLevelReady(int levelNumber);
 
 private:
-    // Player properties
-    QGraphicsRectItem* player{nullptr};
-    qreal playerSpeed{5.0};
-    qreal jumpForce{15.0};
-    qreal gravity{0.8};
-    qreal verticalVelocity{0.0};
-    bool isJumping{false};
+    // Simulation state lives in the world; the items below only mirror it
+    World world;
+    LevelStreamer* streamer{nullptr};
+    int pendingScene{0};
     bool moveLeft{false};
     bool moveRight{false};
-    bool jump{false};
-
-    // Platform properties
-    QTimer* platformTimer{nullptr};
-    QTimer* gameTimer{nullptr};
-    QGraphicsRectItem* movingPlatform{nullptr};
-    QGraphicsRectItem* movingPlatform2{nullptr};
-    int movingPlatformDirection{1};
-    int movingPlatform2Direction{1};
+    bool jumpRequested{false};
+    int jumpPhase{0};
+    bool rewindHeld{false};
+
+    // Key events wait here with the time they arrived, and each tick takes
+    // the ones that arrived before it ends, so where a press lands between
+    // frames doesn't decide which tick sees it
+    struct KeyEvent
+    {
+        std::uint64_t ns{0};  // Profiler::nowNs()
+        int key{0};
+        bool pressed{false};
+    };
+    std::vector<KeyEvent> keyQueue;
+    std::vector<std::uint64_t> consumedKeys;  // arrival times, until painted
+    LatencyHistogram latency;
+
+    // The sky is static, so it's one pixmap rather than items
+    QPixmap backgroundPixmap;
+    QColor backgroundFill;
+
+    // Twinkling stars behind the level and bursts in front of it, each pool
+    // drawn by one item. Both are sized once and live across levels.
+    static constexpr int StarCapacity = 8192;
+    static constexpr int EffectCapacity = 32768;
+    ParticlePool stars{StarCapacity};
+    ParticlePool effects{EffectCapacity};
+    ParticleItem* starItem{nullptr};
+    ParticleItem* effectItem{nullptr};
+    std::mt19937 effectRng;
+    double particleTime{0};  // simulation clock the pools were last updated to
+
+    QVector<QRectF> dirtyRects;
+    bool dirtyAll{true};
+    bool trackDirty{false};
+
+    Player* player{nullptr};
+    // Views of the level's entities by id; null for the player
+    std::vector<QGraphicsItem*> entityItems;
+    // Seconds simulated this session; animations run on this clock
+    double simulationTime{0};
+    std::vector<QGraphicsRectItem*> movingPlatforms;
+
+    // Static geometry is one tile layer per chunk around the camera. Layers
+    // leaving are parked and refilled by the next chunk, so a level never
+    // holds more than a screenful or so of them.
+    QRectF cameraRect{0, 0, 800, 600};
+    ChunkMap chunks;
+    std::vector<TileLayerItem*> chunkLayers;  // by chunk, null while off screen
+    std::vector<TileLayerItem*> freeLayers;
+    std::vector<int> chunksEntered;
+    std::vector<int> chunksLeft;
+    // Input of the whole session, one segment per level played
+    InputJournal journal;
+    std::uint32_t sessionSeed{0};
+
+    // Owns every item of the current level, freed when it's swapped out
+    LevelArena levelArena;
+
+    FrameScheduler* scheduler{nullptr};
     int currentScene{1};
+    bool blockingLoads{false};
+
+    // Frame stages, run in this order by the scheduler
+    void simulate(double elapsedSeconds);
+    void present();
+    // Applies the keys that arrived before tickEndNs to the world's input
+    // for the tick spanning the tickSeconds before it
+    void latchInput(std::uint64_t tickEndNs);
+    void queueKey(QKeyEvent* event, bool pressed);
 
     // Scene creation functions
     void createScene(int sceneNumber);
-    void createPlatforms(int sceneNumber);
-    void createSpikes(int sceneNumber);
+    void showLevel(PreparedLevel& level);
+    void createMovers();
+    void showChunk(int chunk);
+    void hideChunk(int chunk);
+    void updateCamera(bool snap);
+    void updateChunks();
+    void createEntities();
+    void createStars(const PreparedLevel& level);
+    void spawnEffects(unsigned events);
+    void updateParticles();
+    template <typename Item, typename... Args>
+    Item* createLevelItem(Args&&... args)
+    {
+        Item* item = levelArena.create<Item>(std::forward<Args>(args)...);
+        addItem(item);
+        return item;
+    }
+    void syncItems();
+    void markDirty(const QRectF& rect);
+    void moveItem(QGraphicsItem* item, const QPointF& pos);
 };
 
 #endif // GAMESCENE_H
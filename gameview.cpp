@@ -0,0 +1,255 @@
+#include "gameview.h"
+#include <QKeyEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QPainter>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <utility>
+
+GameView::GameView(GameScene *scene, QWidget *parent)
+    : QGraphicsView(scene, parent),
+    gameScene(scene)
+{
+    connect(gameScene, &GameScene::frameAdvanced, this, &GameView::onFrameAdvanced);
+    gameScene->setTrackDirtyRects(true);
+    setRenderMode(DirtyRects);
+}
+
+void GameView::setRenderMode(RenderMode renderMode)
+{
+    mode = renderMode;
+    switch (mode) {
+    case FullUpdate:
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        break;
+    case QtMinimalUpdate:
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+        break;
+    case DirtyRects:
+        // We schedule every repaint ourselves from the scene's dirty rects
+        setViewportUpdateMode(QGraphicsView::NoViewportUpdate);
+        break;
+    }
+    viewport()->update();
+}
+
+void GameView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_F2 && !event->isAutoRepeat()) {
+        // Cycle render modes to compare their cost
+        setRenderMode(RenderMode((mode + 1) % 3));
+        return;
+    }
+    FrameScheduler *scheduler = gameScene->frameScheduler();
+    if (event->key() == Qt::Key_F3 && !event->isAutoRepeat()) {
+        // Pace frames by the precise timer or by the window's update requests
+        const bool timed = scheduler->pacing() == FrameScheduler::Pacing::PreciseTimer;
+        scheduler->setPacing(timed ? FrameScheduler::Pacing::WindowUpdate
+                                   : FrameScheduler::Pacing::PreciseTimer,
+                             window()->windowHandle());
+        scheduler->resetWorstInterval();
+        return;
+    }
+    if (event->key() == Qt::Key_F5 && !event->isAutoRepeat()) {
+        showProfiler = !showProfiler;
+        framesSinceProfile = 0;
+        // Latency counts from when the panel opens, so changes can be compared
+        if (showProfiler)
+            gameScene->resetInputLatency();
+        profile = Profiler::instance().summarize(1.0);
+        memory = gameScene->levelMemory();
+        viewport()->update();
+        return;
+    }
+    if (event->key() == Qt::Key_F6 && !event->isAutoRepeat()) {
+        // Whatever is still in the ring, roughly the last few seconds
+        const QString path = QDir::current().absoluteFilePath("frame-trace.json");
+        if (Profiler::instance().writeChromeTrace(path.toStdString()))
+            qDebug() << "Wrote frame trace to" << path;
+        else
+            qWarning() << "Cannot write frame trace to" << path;
+        return;
+    }
+    if (event->key() == Qt::Key_F7 && !event->isAutoRepeat()) {
+        // Attach this to bug reports; --replay re-simulates it
+        const QString name = QDateTime::currentDateTime().toString("'session-'yyyyMMdd-hhmmss'.jrn'");
+        const QString path = QDir::current().absoluteFilePath(name);
+        QString error;
+        if (gameScene->saveJournal(path, &error))
+            qDebug() << "Wrote input journal to" << path;
+        else
+            qWarning() << "Cannot write input journal to" << path << ":" << error;
+        return;
+    }
+    if (event->key() == Qt::Key_F4 && !event->isAutoRepeat()) {
+        const bool catchUp = scheduler->policy() == FrameScheduler::Policy::CatchUp;
+        scheduler->setPolicy(catchUp ? FrameScheduler::Policy::SkipFrames
+                                     : FrameScheduler::Policy::CatchUp);
+        return;
+    }
+    QGraphicsView::keyPressEvent(event);
+}
+
+void GameView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    gameScene->setViewportSize(viewport()->size());
+}
+
+void GameView::onFrameAdvanced()
+{
+    // Scroll to the scene's camera; the scene marks everything dirty when it moves
+    if (gameScene->camera() != shownCamera) {
+        shownCamera = gameScene->camera();
+        centerOn(shownCamera.center());
+    }
+
+    dirtyRects.clear();
+    const bool everything = gameScene->takeDirtyRects(dirtyRects);
+
+    // Summarizing copies the whole ring, so only a few times a second
+    if (showProfiler && ++framesSinceProfile >= 15) {
+        framesSinceProfile = 0;
+        // The panel follows the number of stages; clear what it shrinks off
+        const QRect before = profilerRect();
+        profile = Profiler::instance().summarize(1.0);
+        memory = gameScene->levelMemory();
+        if (profilerRect() != before)
+            viewport()->update(before);
+    }
+
+    if (mode != DirtyRects) {
+        // Qt schedules the scene; only keep the counters fresh
+        viewport()->update(hudRect());
+        if (showProfiler)
+            viewport()->update(profilerRect());
+        return;
+    }
+
+    if (everything) {
+        viewport()->update();
+        return;
+    }
+
+    QRegion region;
+    for (const QRectF &rect : std::as_const(dirtyRects)) {
+        // Pad for antialiased edges straddling pixel boundaries
+        region += mapFromScene(rect).boundingRect().adjusted(-2, -2, 2, 2);
+    }
+    region += hudRect();
+    if (showProfiler)
+        region += profilerRect();
+    viewport()->update(region);
+}
+
+void GameView::paintEvent(QPaintEvent *event)
+{
+    qint64 pixels = 0;
+    for (const QRect &rect : event->region())
+        pixels += qint64(rect.width()) * rect.height();
+    paintedPixels = pixels;
+
+    {
+        ProfileScope scope("paint");
+        QGraphicsView::paintEvent(event);
+    }
+
+    QPainter painter(viewport());
+    drawHud(&painter);
+    if (showProfiler)
+        drawProfiler(&painter);
+    painter.end();
+    gameScene->framePainted();
+}
+
+QRect GameView::hudRect() const
+{
+    return QRect(4, 4, 340, 36);
+}
+
+void GameView::drawHud(QPainter *painter)
+{
+    static const char *modeNames[] = {"full", "qt-minimal", "dirty-rects"};
+    const qint64 viewportPixels = qint64(viewport()->width()) * viewport()->height();
+    const double share = viewportPixels ? 100.0 * paintedPixels / viewportPixels : 0.0;
+
+    const FrameScheduler *scheduler = gameScene->frameScheduler();
+    const FrameScheduler::FrameStats &stats = scheduler->stats();
+    const bool timed = scheduler->pacing() == FrameScheduler::Pacing::PreciseTimer;
+    const bool catchUp = scheduler->policy() == FrameScheduler::Policy::CatchUp;
+
+    painter->fillRect(hudRect(), QColor(0, 0, 0, 160));
+    painter->setPen(Qt::white);
+    painter->drawText(hudRect().adjusted(4, 0, 0, 0), Qt::AlignTop,
+                      QString("F2 %1 | painted %2 px (%3%)")
+                          .arg(modeNames[mode])
+                          .arg(paintedPixels)
+                          .arg(share, 0, 'f', 1));
+    painter->drawText(hudRect().adjusted(4, 0, 0, 0), Qt::AlignBottom,
+                      QString("F3 %1 F4 %2 | %3 ms, worst %4, late %5")
+                          .arg(timed ? "timer" : "window")
+                          .arg(catchUp ? "catch-up" : "skip")
+                          .arg(stats.lastInterval * 1000, 0, 'f', 1)
+                          .arg(stats.worstInterval * 1000, 0, 'f', 1)
+                          .arg(stats.lateFrames));
+}
+
+QRect GameView::profilerRect() const
+{
+    // Grows up from the bottom edge, one line per stage, as far as fits
+    const int lines = ProfilerFixedLines + int(profile.stages.size());
+    const int height = qMin(2 + lines * ProfilerLineHeight + 2, viewport()->height() - 8);
+    return QRect(4, viewport()->height() - 4 - height, 260, height);
+}
+
+void GameView::drawProfiler(QPainter *painter)
+{
+    const QRect rect = profilerRect();
+    painter->fillRect(rect, QColor(0, 0, 0, 160));
+    painter->setPen(Qt::white);
+
+    const int total = ProfilerFixedLines + int(profile.stages.size());
+    const int fitting = (rect.height() - 4) / ProfilerLineHeight;
+    int shown = 0;
+    int y = rect.top() + 2;
+    auto line = [&](const QString &text) {
+        if (shown >= fitting)
+            return;
+        ++shown;
+        // On a short viewport the last line says what didn't fit
+        const QString drawn = shown == fitting && total > fitting
+                                  ? QString("  ... %1 more lines").arg(total - fitting + 1)
+                                  : text;
+        painter->drawText(QRect(rect.left() + 4, y, rect.width() - 8, ProfilerLineHeight), Qt::AlignVCenter, drawn);
+        y += ProfilerLineHeight;
+    };
+
+    line(QString("F5 profiler, F6 trace | %1 frames/s").arg(profile.frames));
+    line(QString("frame p50 %1 ms, p99 %2 ms")
+             .arg(profile.frameP50Ms, 0, 'f', 2)
+             .arg(profile.frameP99Ms, 0, 'f', 2));
+    line(QString("scanned per pass avg %1, max %2")
+             .arg(profile.scannedAverage, 0, 'f', 1)
+             .arg(profile.scannedMax));
+    line(QString("level %1 objects, arena %2/%3 KiB, RSS %4 MiB")
+             .arg(memory.objects)
+             .arg(memory.arenaBytes / 1024)
+             .arg(memory.arenaReserved / 1024)
+             .arg(memory.residentBytes / (1024 * 1024)));
+    line(QString("chunks %1 of %2 live").arg(memory.activeChunks).arg(memory.chunks));
+    const LatencyHistogram &latency = gameScene->inputLatency();
+    line(QString("key to paint, %1 keys:").arg(latency.count()));
+    line(QString("  p50 %1 p90 %2 p99 %3 max %4 ms")
+             .arg(latency.percentileMs(0.50), 0, 'f', 1)
+             .arg(latency.percentileMs(0.90), 0, 'f', 1)
+             .arg(latency.percentileMs(0.99), 0, 'f', 1)
+             .arg(latency.maxMs(), 0, 'f', 1));
+    for (const Profiler::StageTime &stage : profile.stages) {
+        line(QString("  %1 %2 ms/frame (max %3)")
+                 .arg(QString::fromLatin1(stage.name), -14)
+                 .arg(stage.averageMs, 0, 'f', 3)
+                 .arg(stage.maxMs, 0, 'f', 2));
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef GAMEVIEW_H
+#define GAMEVIEW_H
+
+#include <QGraphicsView>
+#include <QVector>
+#include <QRectF>
+#include "gamescene.h"
+#include "profiler.h"
+
+class GameView : public QGraphicsView
+{
+    Q_OBJECT
+
+public:
+    enum RenderMode {
+        FullUpdate,     // repaint the whole viewport every frame
+        QtMinimalUpdate,// let QGraphicsView work out what changed
+        DirtyRects      // repaint only what the scene reports as moved
+    };
+
+    explicit GameView(GameScene *scene, QWidget *parent = nullptr);
+
+    void setRenderMode(RenderMode mode);
+    RenderMode renderMode() const { return mode; }
+    qint64 lastPaintedPixels() const { return paintedPixels; }
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void onFrameAdvanced();
+
+private:
+    QRect hudRect() const;
+    void drawHud(QPainter *painter);
+    // Lines the profiler panel shows besides one per stage
+    static constexpr int ProfilerFixedLines = 7;
+    static constexpr int ProfilerLineHeight = 15;
+    QRect profilerRect() const;
+    void drawProfiler(QPainter *painter);
+
+    GameScene *gameScene{nullptr};
+    RenderMode mode{DirtyRects};
+    QVector<QRectF> dirtyRects;
+    QRectF shownCamera;
+    qint64 paintedPixels{0};
+
+    bool showProfiler{false};
+    Profiler::Summary profile;
+    GameScene::LevelMemory memory;  // reads /proc, so refreshed with the profile
+    int framesSinceProfile{0};
+};
+
+#endif // GAMEVIEW_H
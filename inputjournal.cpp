@@ -0,0 +1,188 @@
+#include "inputjournal.h"
+#include "world.h"
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+enum InputBits : std::uint8_t {
+    MoveLeftBit = 1 << 0,
+    MoveRightBit = 1 << 1,
+    JumpBit = 1 << 2,
+    RewindBit = 1 << 3,
+    JumpPhaseShift = 4,  // bits 4-6; old journals have 0, a press on the tick boundary
+    JumpPhaseMask = 7 << JumpPhaseShift
+};
+
+struct JournalHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t seed;
+    std::uint32_t segmentCount;
+};
+
+struct SegmentHeader
+{
+    std::int32_t level;
+    std::uint32_t runCount;
+    double ticksPerSecond;
+    std::uint64_t ticks;
+    std::uint64_t endHash;
+};
+
+// Far above any rate a session is played at; keeps the ticks a world's
+// rewind history holds well inside an int
+constexpr double MaxTicksPerSecond = 10000;
+
+static_assert(sizeof(JournalHeader) == 16, "journal header must stay packed");
+static_assert(sizeof(SegmentHeader) == 32, "segment header must stay packed");
+static_assert(sizeof(InputJournal::InputRun) == 8, "input runs must stay packed");
+
+struct FileCloser
+{
+    void operator()(std::FILE *file) const { std::fclose(file); }
+};
+using File = std::unique_ptr<std::FILE, FileCloser>;
+
+bool fail(std::string *error, const char *message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+} // namespace
+
+std::uint8_t InputJournal::pack(const PlayerInput &input)
+{
+    return std::uint8_t((input.moveLeft ? MoveLeftBit : 0) | (input.moveRight ? MoveRightBit : 0)
+                        | (input.jump ? JumpBit : 0) | (input.rewind ? RewindBit : 0)
+                        | (input.jump ? (input.jumpPhase << JumpPhaseShift) & JumpPhaseMask : 0));
+}
+
+PlayerInput InputJournal::unpack(std::uint8_t bits)
+{
+    PlayerInput input;
+    input.moveLeft = bits & MoveLeftBit;
+    input.moveRight = bits & MoveRightBit;
+    input.jump = bits & JumpBit;
+    input.rewind = bits & RewindBit;
+    input.jumpPhase = std::uint8_t((bits & JumpPhaseMask) >> JumpPhaseShift);
+    return input;
+}
+
+void InputJournal::beginSegment(int level, double ticksPerSecond)
+{
+    Segment segment;
+    segment.level = level;
+    segment.ticksPerSecond = ticksPerSecond;
+    recorded.push_back(std::move(segment));
+    open = true;
+}
+
+void InputJournal::record(const PlayerInput &input)
+{
+    if (!open)
+        return;
+    Segment &segment = recorded.back();
+    const std::uint8_t bits = pack(input);
+    if (segment.runs.empty() || segment.runs.back().bits != bits
+        || segment.runs.back().length == UINT32_MAX) {
+        InputRun run;
+        run.bits = bits;
+        segment.runs.push_back(run);
+    }
+    ++segment.runs.back().length;
+    ++segment.ticks;
+}
+
+void InputJournal::endSegment(std::uint64_t stateHash)
+{
+    if (!open)
+        return;
+    recorded.back().endHash = stateHash;
+    open = false;
+}
+
+void InputJournal::clear()
+{
+    recorded.clear();
+    open = false;
+}
+
+bool InputJournal::save(const std::string &path, std::string *error) const
+{
+    File file(std::fopen(path.c_str(), "wb"));
+    if (!file)
+        return fail(error, "cannot open journal for writing");
+
+    const JournalHeader header{Magic, Version, sessionSeed, std::uint32_t(recorded.size())};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file.get()) == 1;
+    for (const Segment &segment : recorded) {
+        const SegmentHeader head{segment.level, std::uint32_t(segment.runs.size()), segment.ticksPerSecond,
+                                 segment.ticks, segment.endHash};
+        ok = ok && std::fwrite(&head, sizeof(head), 1, file.get()) == 1;
+        ok = ok && std::fwrite(segment.runs.data(), sizeof(InputRun), segment.runs.size(), file.get())
+                       == segment.runs.size();
+    }
+    if (!ok || std::fflush(file.get()) != 0)
+        return fail(error, "cannot write journal");
+    return true;
+}
+
+bool InputJournal::load(const std::string &path, std::string *error)
+{
+    clear();
+    std::vector<Segment> segments;
+    File file(std::fopen(path.c_str(), "rb"));
+    if (!file)
+        return fail(error, "cannot open journal");
+    // Counts in the file are checked against its size before anything is
+    // allocated for them
+    if (std::fseek(file.get(), 0, SEEK_END) != 0)
+        return fail(error, "cannot read journal");
+    const long fileSize = std::ftell(file.get());
+    if (fileSize < 0 || std::fseek(file.get(), 0, SEEK_SET) != 0)
+        return fail(error, "cannot read journal");
+
+    JournalHeader header;
+    if (std::fread(&header, sizeof(header), 1, file.get()) != 1)
+        return fail(error, "journal is truncated");
+    if (header.magic != Magic)
+        return fail(error, "not an input journal");
+    if (header.version != Version)
+        return fail(error, "unsupported journal version");
+
+    for (std::uint32_t i = 0; i < header.segmentCount; ++i) {
+        SegmentHeader head;
+        if (std::fread(&head, sizeof(head), 1, file.get()) != 1)
+            return fail(error, "segment header is truncated");
+        Segment segment;
+        segment.level = head.level;
+        // Worlds are built at this rate, so no zero, negative, NaN or absurd ones
+        if (!(head.ticksPerSecond > 0) || !(head.ticksPerSecond <= MaxTicksPerSecond))
+            return fail(error, "segment tick rate is invalid");
+        segment.ticksPerSecond = head.ticksPerSecond;
+        segment.ticks = head.ticks;
+        segment.endHash = head.endHash;
+        const long remaining = fileSize - std::ftell(file.get());
+        if (head.runCount > std::uint64_t(remaining) / sizeof(InputRun))
+            return fail(error, "segment inputs are truncated");
+        segment.runs.resize(head.runCount);
+        if (std::fread(segment.runs.data(), sizeof(InputRun), head.runCount, file.get()) != head.runCount)
+            return fail(error, "segment inputs are truncated");
+
+        std::uint64_t ticks = 0;
+        for (const InputRun &run : segment.runs)
+            ticks += run.length;
+        if (ticks != segment.ticks)
+            return fail(error, "segment tick count doesn't match its inputs");
+        segments.push_back(std::move(segment));
+    }
+
+    // Only take a journal that loaded completely
+    recorded = std::move(segments);
+    sessionSeed = header.seed;
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef INPUTJOURNAL_H
+#define INPUTJOURNAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PlayerInput;
+
+// Per-tick record of the input the world consumed, enough to re-simulate a
+// session exactly. A session is a list of segments, one per level played
+// from the moment it was swapped in; each ends with the hash of the world
+// state it reached, so a replay can tell where it first diverged.
+//
+// On disk (little endian, like the level format):
+//   JournalHeader, then per segment a SegmentHeader followed by runCount
+//   InputRun records. Inputs are run-length encoded, since held keys
+//   rarely change from one tick to the next.
+class InputJournal
+{
+public:
+    static constexpr std::uint32_t Magic = 0x314e524a;  // "JRN1"
+    static constexpr std::uint32_t Version = 2;  // 2: end hashes cover the whole state block
+
+    struct InputRun
+    {
+        std::uint32_t length{0};  // ticks
+        std::uint8_t bits{0};     // packed PlayerInput
+        std::uint8_t reserved[3]{};
+    };
+
+    struct Segment
+    {
+        int level{0};
+        double ticksPerSecond{60};
+        std::uint64_t ticks{0};
+        std::uint64_t endHash{0};
+        std::vector<InputRun> runs;
+    };
+
+    static std::uint8_t pack(const PlayerInput &input);
+    static PlayerInput unpack(std::uint8_t bits);
+
+    // Seeds everything random in the session (star layout so far)
+    void setSeed(std::uint32_t seed) { sessionSeed = seed; }
+    std::uint32_t seed() const { return sessionSeed; }
+
+    void beginSegment(int level, double ticksPerSecond);
+    void record(const PlayerInput &input);
+    void endSegment(std::uint64_t stateHash);
+    bool hasOpenSegment() const { return open; }
+
+    const std::vector<Segment> &segments() const { return recorded; }
+    void clear();
+
+    bool save(const std::string &path, std::string *error = nullptr) const;
+    bool load(const std::string &path, std::string *error = nullptr);
+
+private:
+    std::vector<Segment> recorded;
+    std::uint32_t sessionSeed{0};
+    bool open{false};
+};
+
+#endif // INPUTJOURNAL_H
@@ -0,0 +1,69 @@
+#include "kinematicpath.h"
+#include <algorithm>
+#include <cmath>
+
+KinematicPath::KinematicPath(std::vector<PathPoint> waypoints, PathMode pathMode, PathEasing pathEasing,
+                             float pathSpeed, float startPhase)
+    : points(std::move(waypoints)),
+    mode(pathMode),
+    easing(pathEasing),
+    speed(pathSpeed),
+    phase(startPhase)
+{
+    // A loop is a closed polyline, so walk back to the start as well
+    if (mode == PathMode::Loop && points.size() > 1)
+        points.push_back(points.front());
+
+    distances.reserve(points.size());
+    float distance = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i > 0)
+            distance += std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+        distances.push_back(distance);
+    }
+    totalLength = distance;
+}
+
+PathPoint KinematicPath::at(double ticks) const
+{
+    if (points.empty())
+        return PathPoint();
+    if (points.size() == 1 || totalLength <= 0)
+        return points.front();
+
+    // Distance travelled, folded back onto the path. Doubles keep long
+    // sessions exact enough; the result is only rounded to float at the end.
+    double d = phase + double(speed) * ticks;
+    switch (mode) {
+    case PathMode::Once:
+        d = std::clamp(d, 0.0, double(totalLength));
+        break;
+    case PathMode::Loop:
+        d = std::fmod(d, double(totalLength));
+        if (d < 0)
+            d += totalLength;
+        break;
+    case PathMode::PingPong: {
+        const double period = 2.0 * totalLength;
+        d = std::fmod(d, period);
+        if (d < 0)
+            d += period;
+        if (d > totalLength)
+            d = period - d;
+        break;
+    }
+    }
+
+    // Segment containing d, then where along it
+    const auto next = std::upper_bound(distances.begin(), distances.end(), float(d));
+    const size_t segment = std::min(size_t(std::max<std::ptrdiff_t>(next - distances.begin(), 1)), points.size() - 1) - 1;
+    const float segmentLength = distances[segment + 1] - distances[segment];
+    float u = segmentLength > 0 ? float((d - distances[segment]) / segmentLength) : 1.0f;
+    u = std::clamp(u, 0.0f, 1.0f);
+    if (easing == PathEasing::Smooth)
+        u = u * u * (3 - 2 * u);
+
+    const PathPoint &a = points[segment];
+    const PathPoint &b = points[segment + 1];
+    return {a.x + (b.x - a.x) * u, a.y + (b.y - a.y) * u};
+}
@@ -0,0 +1,51 @@
+#ifndef KINEMATICPATH_H
+#define KINEMATICPATH_H
+
+#include <cstdint>
+#include <vector>
+
+enum class PathMode : std::uint8_t
+{
+    Once,      // stop at the last waypoint
+    PingPong,  // run back and forth along the waypoints
+    Loop       // closed: the last waypoint runs back to the first
+};
+
+enum class PathEasing : std::uint8_t
+{
+    Linear,
+    Smooth     // ease in and out of every waypoint
+};
+
+struct PathPoint
+{
+    float x{0};
+    float y{0};
+};
+
+// Motion along waypoints as a pure function of time. Nothing is integrated
+// per tick, so positions never drift, skipping ahead costs one evaluation
+// and any earlier tick can be recomputed exactly (replays, rewind).
+class KinematicPath
+{
+public:
+    KinematicPath() = default;
+    // speed in px per reference tick along the path; phase is the distance
+    // along the path at time zero
+    KinematicPath(std::vector<PathPoint> points, PathMode mode, PathEasing easing, float speed, float phase = 0);
+
+    // Position after the given number of reference ticks
+    PathPoint at(double ticks) const;
+    float length() const { return totalLength; }
+
+private:
+    std::vector<PathPoint> points;
+    std::vector<float> distances;  // along the path to each point
+    PathMode mode{PathMode::Once};
+    PathEasing easing{PathEasing::Linear};
+    float speed{0};
+    float phase{0};
+    float totalLength{0};
+};
+
+#endif // KINEMATICPATH_H
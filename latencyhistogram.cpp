@@ -0,0 +1,37 @@
+#include "latencyhistogram.h"
+#include <algorithm>
+
+void LatencyHistogram::add(std::uint64_t ns)
+{
+    const std::uint64_t bucket = std::min<std::uint64_t>(ns / BucketNs, Buckets - 1);
+    ++buckets[std::size_t(bucket)];
+    ++samples;
+    largestNs = std::max(largestNs, ns);
+}
+
+void LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    samples = 0;
+    largestNs = 0;
+}
+
+double LatencyHistogram::percentileMs(double p) const
+{
+    if (samples == 0)
+        return 0;
+    // Same rank as the profiler's frame percentiles
+    const std::uint64_t rank = std::min(samples - 1, std::uint64_t(std::max(0.0, p) * double(samples)));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < Buckets; ++i) {
+        seen += buckets[std::size_t(i)];
+        if (seen > rank)
+            return std::min(double(i + 1) * BucketNs, double(largestNs)) / 1e6;
+    }
+    return maxMs();
+}
+
+double LatencyHistogram::maxMs() const
+{
+    return double(largestNs) / 1e6;
+}
@@ -0,0 +1,31 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+
+// Distribution of latencies in fixed 0.1 ms buckets up to Range, so adding
+// a sample is one increment and a session's worth costs no memory growth.
+// Samples past the range land in the last bucket; max() still has them
+// exact. No Qt, like the profiler.
+class LatencyHistogram
+{
+public:
+    static constexpr std::uint64_t BucketNs = 100000;
+    static constexpr int Buckets = 2500;  // 250 ms
+
+    void add(std::uint64_t ns);
+    void reset();
+
+    std::uint64_t count() const { return samples; }
+    // Upper edge of the bucket holding the p-th sample, p in [0, 1]
+    double percentileMs(double p) const;
+    double maxMs() const;
+
+private:
+    std::array<std::uint32_t, Buckets> buckets{};
+    std::uint64_t samples{0};
+    std::uint64_t largestNs{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,86 @@
+#include "levelarena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+LevelArena::LevelArena(std::size_t size) : blockSize(size)
+{
+}
+
+LevelArena::~LevelArena()
+{
+    reset();
+}
+
+void *LevelArena::allocate(std::size_t size, std::size_t alignment)
+{
+    while (currentBlock < blocks.size()) {
+        Block &block = blocks[currentBlock];
+        const auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+        const std::size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned + size <= block.size) {
+            offset = aligned + size;
+            return block.data.get() + aligned;
+        }
+        // Doesn't fit; move on to the next kept block, or grow below
+        ++currentBlock;
+        offset = 0;
+    }
+
+    const std::size_t bytes = std::max(blockSize, size + alignment);
+    blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[bytes]), bytes});
+    currentBlock = blocks.size() - 1;
+    offset = 0;
+    return allocate(size, alignment);
+}
+
+void LevelArena::reset()
+{
+    for (Finalizer *f = finalizers; f; f = f->next)
+        f->destroy(f->object);
+    finalizers = nullptr;
+    objects = 0;
+    currentBlock = 0;
+    offset = 0;
+}
+
+void LevelArena::release()
+{
+    reset();
+    blocks.clear();
+}
+
+std::size_t LevelArena::bytesUsed() const
+{
+    std::size_t used = offset;
+    for (std::size_t i = 0; i < currentBlock && i < blocks.size(); ++i)
+        used += blocks[i].size;
+    return used;
+}
+
+std::size_t LevelArena::bytesReserved() const
+{
+    std::size_t reserved = 0;
+    for (const Block &block : blocks)
+        reserved += block.size;
+    return reserved;
+}
+
+std::size_t processResidentBytes()
+{
+#if defined(__linux__)
+    unsigned long pages = 0, resident = 0;
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &pages, &resident);
+    std::fclose(statm);
+    return fields == 2 ? std::size_t(resident) * std::size_t(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,72 @@
+#ifndef LEVELARENA_H
+#define LEVELARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for objects that live exactly as long as a level. Objects
+// are constructed in place in large blocks; reset() runs their destructors
+// newest first and rewinds the blocks, which are kept for the next level, so
+// reloading levels doesn't grow the heap.
+class LevelArena
+{
+public:
+    explicit LevelArena(std::size_t blockSize = 32 * 1024);
+    ~LevelArena();
+    LevelArena(const LevelArena &) = delete;
+    LevelArena &operator=(const LevelArena &) = delete;
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        void *memory = allocate(sizeof(T), alignof(T));
+        T *object = new (memory) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            void *slot = allocate(sizeof(Finalizer), alignof(Finalizer));
+            finalizers = new (slot) Finalizer{[](void *p) { static_cast<T *>(p)->~T(); }, object, finalizers};
+        }
+        ++objects;
+        return object;
+    }
+
+    void *allocate(std::size_t size, std::size_t alignment);
+
+    // Destroys every object, keeping the blocks for reuse
+    void reset();
+    // Also returns the blocks to the heap
+    void release();
+
+    std::size_t objectCount() const { return objects; }
+    std::size_t bytesUsed() const;
+    std::size_t bytesReserved() const;
+
+private:
+    struct Finalizer
+    {
+        void (*destroy)(void *);
+        void *object;
+        Finalizer *next;
+    };
+
+    struct Block
+    {
+        std::unique_ptr<unsigned char[]> data;
+        std::size_t size;
+    };
+
+    std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t currentBlock{0};
+    std::size_t offset{0};
+    Finalizer *finalizers{nullptr};
+    std::size_t objects{0};
+};
+
+// Resident set size of this process in bytes, or 0 where it can't be read
+std::size_t processResidentBytes();
+
+#endif // LEVELARENA_H
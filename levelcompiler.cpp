@@ -0,0 +1,198 @@
+#include "levelcompiler.h"
+#include "levelformat.h"
+#include <QColor>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+bool readRect(const QJsonValue &value, WorldRect &rect)
+{
+    const QJsonArray a = value.toArray();
+    if (a.size() != 4)
+        return false;
+    rect = {float(a[0].toDouble()), float(a[1].toDouble()), float(a[2].toDouble()), float(a[3].toDouble())};
+    return rect.width >= 0 && rect.height >= 0;
+}
+
+bool readColor(const QJsonValue &value, std::uint32_t fallback, std::uint32_t &out)
+{
+    if (value.isUndefined()) {
+        out = fallback;
+        return true;
+    }
+    const QColor color(value.toString());
+    out = color.rgba();
+    return color.isValid();
+}
+
+} // namespace
+
+QByteArray compileLevel(const QByteArray &json, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return QByteArray();
+    };
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (document.isNull())
+        return fail(parseError.errorString());
+    const QJsonObject root = document.object();
+
+    LevelBuilder builder;
+
+    const QJsonArray size = root.value("size").toArray();
+    if (size.size() == 2)
+        builder.setBounds(size[0].toDouble(), size[1].toDouble());
+    const QJsonArray spawn = root.value("spawn").toArray();
+    if (spawn.size() == 2)
+        builder.setSpawn(spawn[0].toDouble(), spawn[1].toDouble());
+
+    LevelFormat::Decoration decoration{};
+    const QJsonObject sky = root.value("sky").toObject();
+    if (!readColor(sky.value("top"), 0xff1e1e3c, decoration.skyTop)
+        || !readColor(sky.value("bottom"), 0xff0a0a1e, decoration.skyBottom))
+        return fail("invalid sky color");
+    const QJsonObject stars = root.value("stars").toObject();
+    decoration.starCount = std::uint32_t(stars.value("count").toInt(0));
+    decoration.starMaxY = float(stars.value("maxY").toDouble(300));
+    builder.setDecoration(decoration);
+
+    for (const QJsonValue &value : root.value("platforms").toArray()) {
+        const QJsonObject platform = value.toObject();
+        WorldRect rect;
+        if (!readRect(platform.value("rect"), rect))
+            return fail("platform needs a rect of [x, y, width, height]");
+
+        const QString kind = platform.value("kind").toString("solid");
+        ColliderKind colliderKind;
+        if (kind == "solid")
+            colliderKind = ColliderKind::Solid;
+        else if (kind == "oneway")
+            colliderKind = ColliderKind::OneWay;
+        else if (kind == "hazard")
+            colliderKind = ColliderKind::Hazard;
+        else
+            return fail(QString("unknown platform kind '%1'").arg(kind));
+
+        const QString style = platform.value("style").toString("ledge");
+        PlatformStyle platformStyle;
+        if (style == "ledge")
+            platformStyle = PlatformStyle::Ledge;
+        else if (style == "ground")
+            platformStyle = PlatformStyle::Ground;
+        else if (style == "spike")
+            platformStyle = PlatformStyle::Spike;
+        else
+            return fail(QString("unknown platform style '%1'").arg(style));
+
+        builder.addCollider(rect, colliderKind, platformStyle);
+    }
+
+    for (const QJsonValue &value : root.value("movers").toArray()) {
+        const QJsonObject mover = value.toObject();
+        WorldRect rect;
+        if (!readRect(mover.value("rect"), rect))
+            return fail("mover needs a rect of [x, y, width, height]");
+
+        // Waypoints are offsets from the rect: "path": [[0, 0], [0, -120], ...]
+        if (mover.contains("path")) {
+            std::vector<PathPoint> points;
+            for (const QJsonValue &point : mover.value("path").toArray()) {
+                const QJsonArray xy = point.toArray();
+                if (xy.size() != 2)
+                    return fail("path points are [dx, dy]");
+                points.push_back({float(xy[0].toDouble()), float(xy[1].toDouble())});
+            }
+            if (points.empty())
+                return fail("mover path needs at least one point");
+
+            const QString modeName = mover.value("mode").toString("pingpong");
+            PathMode mode;
+            if (modeName == "pingpong")
+                mode = PathMode::PingPong;
+            else if (modeName == "loop")
+                mode = PathMode::Loop;
+            else if (modeName == "once")
+                mode = PathMode::Once;
+            else
+                return fail(QString("unknown path mode '%1'").arg(modeName));
+
+            const QString easingName = mover.value("easing").toString("linear");
+            PathEasing easing;
+            if (easingName == "linear")
+                easing = PathEasing::Linear;
+            else if (easingName == "smooth")
+                easing = PathEasing::Smooth;
+            else
+                return fail(QString("unknown path easing '%1'").arg(easingName));
+
+            builder.addPath(rect, points, mode, easing, mover.value("speed").toDouble(1),
+                            mover.value("phase").toDouble(0));
+            continue;
+        }
+
+        const QJsonArray range = mover.value("range").toArray();
+        if (range.size() != 2)
+            return fail("mover needs a range of [min, max]");
+        builder.addMover(rect, range[0].toDouble(), range[1].toDouble(), mover.value("speed").toDouble());
+    }
+
+    for (const QJsonValue &value : root.value("spikes").toArray()) {
+        const QJsonObject row = value.toObject();
+        const QJsonArray at = row.value("at").toArray();
+        if (at.size() != 2)
+            return fail("spike row needs an 'at' of [x, y]");
+        builder.addSpikeRow(at[0].toDouble(), at[1].toDouble(), row.value("count").toInt(1));
+    }
+
+    for (const QJsonValue &value : root.value("entities").toArray()) {
+        const QJsonObject entity = value.toObject();
+        WorldRect rect;
+        if (!readRect(entity.value("rect"), rect))
+            return fail("entity needs a rect of [x, y, width, height]");
+        const QString kind = entity.value("kind").toString();
+        if (kind == "pickup") {
+            builder.addPickup(rect);
+        } else if (kind == "walker") {
+            const QJsonArray range = entity.value("range").toArray();
+            if (range.size() != 2)
+                return fail("walker needs a range of [minX, maxX]");
+            builder.addWalker(rect, range[0].toDouble(), range[1].toDouble(), entity.value("speed").toDouble(1));
+        } else {
+            return fail(QString("unknown entity kind '%1'").arg(kind));
+        }
+    }
+
+    const std::vector<std::uint8_t> image = builder.build();
+    return QByteArray(reinterpret_cast<const char *>(image.data()), int(image.size()));
+}
+
+int compileLevelFile(const QString &inputPath, const QString &outputPath)
+{
+    QFile input(inputPath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        qCritical().noquote() << "Cannot read" << inputPath << ":" << input.errorString();
+        return 1;
+    }
+
+    QString error;
+    const QByteArray image = compileLevel(input.readAll(), &error);
+    if (image.isEmpty()) {
+        qCritical().noquote() << inputPath << ":" << error;
+        return 1;
+    }
+
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly) || output.write(image) != image.size()) {
+        qCritical().noquote() << "Cannot write" << outputPath << ":" << output.errorString();
+        return 1;
+    }
+    return 0;
+}
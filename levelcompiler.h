@@ -0,0 +1,14 @@
+#ifndef LEVELCOMPILER_H
+#define LEVELCOMPILER_H
+
+#include <QByteArray>
+#include <QString>
+
+// Compiles a JSON level (see levels/level1.json) into the binary image read
+// by LevelView. Returns an empty array and sets error on failure.
+QByteArray compileLevel(const QByteArray &json, QString *error = nullptr);
+
+// Command line entry point for --compile-level <in.json> <out.lvl>
+int compileLevelFile(const QString &inputPath, const QString &outputPath);
+
+#endif // LEVELCOMPILER_H
@@ -0,0 +1,112 @@
+#include "levelfile.h"
+#include "levelcompiler.h"
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+// Images compiled from JSON, kept so switching back to a level is as cheap
+// as mapping a compiled one
+QHash<QString, QByteArray> &compiledImages()
+{
+    static QHash<QString, QByteArray> images;
+    return images;
+}
+
+QMutex &compiledImagesMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+} // namespace
+
+LevelFile::~LevelFile()
+{
+    close();
+}
+
+QString LevelFile::compiledPath(int levelNumber)
+{
+    return QCoreApplication::applicationDirPath() + QString("/levels/level%1.lvl").arg(levelNumber);
+}
+
+QString LevelFile::sourcePath(int levelNumber)
+{
+    return QString(":/levels/level%1.json").arg(levelNumber);
+}
+
+bool LevelFile::exists(int levelNumber)
+{
+    return QFile::exists(compiledPath(levelNumber)) || QFile::exists(sourcePath(levelNumber));
+}
+
+bool LevelFile::open(int levelNumber)
+{
+    const QString compiled = compiledPath(levelNumber);
+    if (QFile::exists(compiled))
+        return openPath(compiled);
+    return openPath(sourcePath(levelNumber));
+}
+
+bool LevelFile::openPath(const QString &path)
+{
+    close();
+
+    if (path.endsWith(".lvl")) {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = file.errorString();
+            return false;
+        }
+        mapped = file.map(0, file.size());
+        if (!mapped) {
+            error = file.errorString();
+            file.close();
+            return false;
+        }
+        return parse(mapped, file.size());
+    }
+
+    {
+        QMutexLocker locker(&compiledImagesMutex());
+        image = compiledImages().value(path);
+    }
+    if (image.isEmpty()) {
+        QFile source(path);
+        if (!source.open(QIODevice::ReadOnly)) {
+            error = source.errorString();
+            return false;
+        }
+        image = compileLevel(source.readAll(), &error);
+        if (image.isEmpty()) {
+            error = path + ": " + error;
+            return false;
+        }
+        QMutexLocker locker(&compiledImagesMutex());
+        compiledImages().insert(path, image);
+    }
+    return parse(reinterpret_cast<const uchar *>(image.constData()), image.size());
+}
+
+bool LevelFile::parse(const uchar *data, qint64 size)
+{
+    if (!levelView.parse(data, size_t(size))) {
+        error = QString::fromLatin1(levelView.error());
+        return false;
+    }
+    return true;
+}
+
+void LevelFile::close()
+{
+    levelView = LevelView();
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    file.close();
+    image.clear();
+}
@@ -0,0 +1,43 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include "levelformat.h"
+
+// Owns the bytes behind a LevelView. Compiled levels (levels/levelN.lvl next
+// to the executable) are memory-mapped and read in place; otherwise the JSON
+// bundled in the resources is compiled once per process and reused.
+// Different LevelFile objects may be opened from different threads.
+class LevelFile
+{
+public:
+    LevelFile() = default;
+    ~LevelFile();
+    LevelFile(const LevelFile &) = delete;
+    LevelFile &operator=(const LevelFile &) = delete;
+
+    bool open(int levelNumber);
+    // A .lvl image is mapped, anything else is compiled as JSON
+    bool openPath(const QString &path);
+    void close();
+
+    const LevelView &view() const { return levelView; }
+    QString errorString() const { return error; }
+
+    static bool exists(int levelNumber);
+    static QString compiledPath(int levelNumber);
+    static QString sourcePath(int levelNumber);
+
+private:
+    bool parse(const uchar *data, qint64 size);
+
+    QFile file;
+    uchar *mapped{nullptr};
+    QByteArray image;
+    LevelView levelView;
+    QString error;
+};
+
+#endif // LEVELFILE_H
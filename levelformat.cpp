@@ -0,0 +1,313 @@
+#include "levelformat.h"
+#include <cmath>
+#include <cstring>
+
+using namespace LevelFormat;
+
+namespace {
+
+std::size_t align4(std::size_t n)
+{
+    return (n + 3) & ~std::size_t(3);
+}
+
+std::size_t colliderSectionBytes(std::size_t count)
+{
+    return align4(count * (4 * sizeof(float) + 2));
+}
+
+// False for NaN and infinities as well as for values out of range
+bool bounded(float value)
+{
+    return std::abs(value) <= MaxCoordinate;
+}
+
+} // namespace
+
+bool LevelView::parse(const void *data, std::size_t size)
+{
+    *this = LevelView();
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(LevelHeader) != 0) {
+        lastError = "level image is misaligned";
+        return false;
+    }
+    if (size < sizeof(LevelHeader)) {
+        lastError = "level image is truncated";
+        return false;
+    }
+    head = reinterpret_cast<const LevelHeader *>(bytes);
+    if (head->magic != Magic) {
+        lastError = "not a compiled level";
+        return false;
+    }
+    if (head->version != Version) {
+        lastError = "unsupported level version";
+        return false;
+    }
+    // Sizes feed the chunk map, the broadphase grid and the baked sky;
+    // !(x > 0) catches NaN too
+    if (!(head->width > 0) || !(head->height > 0)
+        || !(head->width <= MaxLevelWidth) || !(head->height <= MaxLevelHeight)) {
+        lastError = "level size is out of range";
+        return false;
+    }
+    if (!bounded(head->spawnX) || !bounded(head->spawnY)) {
+        lastError = "spawn point is out of range";
+        return false;
+    }
+    if (head->sectionCount > (size - sizeof(LevelHeader)) / sizeof(LevelSection)) {
+        lastError = "section table is truncated";
+        return false;
+    }
+
+    const auto *sections = reinterpret_cast<const LevelSection *>(bytes + sizeof(LevelHeader));
+    for (std::uint32_t i = 0; i < head->sectionCount; ++i) {
+        const LevelSection &section = sections[i];
+        if (section.offset % 4 != 0 || section.offset > size || section.bytes > size - section.offset) {
+            lastError = "section lies outside the image";
+            return false;
+        }
+        const std::uint8_t *payload = bytes + section.offset;
+
+        switch (section.tag) {
+        case CollidersTag: {
+            if (section.bytes < colliderSectionBytes(section.count)) {
+                lastError = "collider section is truncated";
+                return false;
+            }
+            const std::uint32_t n = section.count;
+            colliders = n;
+            leftEdges = reinterpret_cast<const float *>(payload);
+            topEdges = leftEdges + n;
+            rightEdges = topEdges + n;
+            bottomEdges = rightEdges + n;
+            kindTags = reinterpret_cast<const std::uint8_t *>(bottomEdges + n);
+            styleTags = kindTags + n;
+            for (std::uint32_t c = 0; c < n; ++c) {
+                if (kindTags[c] > std::uint8_t(ColliderKind::Moving)
+                    || styleTags[c] > std::uint8_t(PlatformStyle::Mover)) {
+                    lastError = "collider has an unknown kind or style";
+                    return false;
+                }
+                if (!bounded(leftEdges[c]) || !bounded(topEdges[c]) || !bounded(rightEdges[c])
+                    || !bounded(bottomEdges[c]) || rightEdges[c] < leftEdges[c] || bottomEdges[c] < topEdges[c]) {
+                    lastError = "collider rect is out of range";
+                    return false;
+                }
+            }
+            break;
+        }
+        case MoversTag:
+            if (section.bytes < section.count * sizeof(MoverRecord)) {
+                lastError = "mover section is truncated";
+                return false;
+            }
+            moverRecords = section.count;
+            moverData = reinterpret_cast<const MoverRecord *>(payload);
+            break;
+        case EntitiesTag:
+            if (section.bytes < section.count * sizeof(EntityRecord)) {
+                lastError = "entity section is truncated";
+                return false;
+            }
+            entityRecords = section.count;
+            entityData = reinterpret_cast<const EntityRecord *>(payload);
+            break;
+        case PathsTag:
+            if (section.bytes < section.count * sizeof(PathRecord)) {
+                lastError = "path section is truncated";
+                return false;
+            }
+            pathRecords = section.count;
+            pathData = reinterpret_cast<const PathRecord *>(payload);
+            break;
+        case PathPointsTag:
+            if (section.bytes < section.count * sizeof(PathPoint)) {
+                lastError = "path point section is truncated";
+                return false;
+            }
+            pathPointCount = section.count;
+            pointData = reinterpret_cast<const PathPoint *>(payload);
+            break;
+        case DecorationTag:
+            if (section.bytes < sizeof(Decoration)) {
+                lastError = "decoration section is truncated";
+                return false;
+            }
+            std::memcpy(&decor, payload, sizeof(Decoration));
+            break;
+        default:
+            // Unknown sections are skipped so newer tools can add data
+            break;
+        }
+    }
+
+    for (std::uint32_t i = 0; i < moverRecords; ++i) {
+        const MoverRecord &mover = moverData[i];
+        if (mover.collider >= colliders) {
+            lastError = "mover refers to a missing collider";
+            return false;
+        }
+        if (!bounded(mover.minOffset) || !bounded(mover.maxOffset) || !bounded(mover.speed)) {
+            lastError = "mover range or speed is out of range";
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < pathPointCount; ++i) {
+        if (!bounded(pointData[i].x) || !bounded(pointData[i].y)) {
+            lastError = "path point is out of range";
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < pathRecords; ++i) {
+        const PathRecord &path = pathData[i];
+        if (path.collider >= colliders) {
+            lastError = "path refers to a missing collider";
+            return false;
+        }
+        if (path.pointCount == 0 || path.firstPoint > pathPointCount
+            || path.pointCount > pathPointCount - path.firstPoint) {
+            lastError = "path points lie outside the point section";
+            return false;
+        }
+        if (path.mode > std::uint8_t(PathMode::Loop) || path.easing > std::uint8_t(PathEasing::Smooth)) {
+            lastError = "path has an unknown mode or easing";
+            return false;
+        }
+        if (!bounded(path.speed) || !bounded(path.phase)) {
+            lastError = "path speed or phase is out of range";
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < entityRecords; ++i) {
+        const std::uint32_t kind = entityData[i].kind;
+        if (kind != std::uint32_t(EntityKind::Walker) && kind != std::uint32_t(EntityKind::Pickup)) {
+            lastError = "entity has an unknown kind";
+            return false;
+        }
+        const EntityRecord &entity = entityData[i];
+        if (!bounded(entity.left) || !bounded(entity.top) || !bounded(entity.minX) || !bounded(entity.maxX)
+            || !bounded(entity.speed) || !(entity.width >= 0) || !(entity.height >= 0)
+            || !bounded(entity.width) || !bounded(entity.height)) {
+            lastError = "entity rect, range or speed is out of range";
+            return false;
+        }
+    }
+    if (!bounded(decor.starMaxY)) {
+        lastError = "decoration is out of range";
+        return false;
+    }
+    return true;
+}
+
+void LevelBuilder::setBounds(float width, float height)
+{
+    head.width = width;
+    head.height = height;
+}
+
+void LevelBuilder::setSpawn(float x, float y)
+{
+    head.spawnX = x;
+    head.spawnY = y;
+}
+
+void LevelBuilder::setDecoration(const Decoration &decoration)
+{
+    decor = decoration;
+}
+
+int LevelBuilder::addCollider(const WorldRect &rect, ColliderKind kind, PlatformStyle style)
+{
+    return colliders.add(rect, kind, style);
+}
+
+void LevelBuilder::addMover(const WorldRect &rect, float minOffset, float maxOffset, float speed)
+{
+    const int collider = colliders.add(rect, ColliderKind::Moving, PlatformStyle::Mover);
+    movers.push_back({std::uint32_t(collider), minOffset, maxOffset, speed});
+}
+
+void LevelBuilder::addSpikeRow(float x, float y, int count)
+{
+    for (int i = 0; i < count; ++i)
+        colliders.add({x + i * 20.0f, y, 20, 20}, ColliderKind::Hazard, PlatformStyle::Spike);
+}
+
+void LevelBuilder::addPath(const WorldRect &rect, const std::vector<PathPoint> &points, PathMode mode,
+                           PathEasing easing, float speed, float phase)
+{
+    const int collider = colliders.add(rect, ColliderKind::Moving, PlatformStyle::Mover);
+    paths.push_back({std::uint32_t(collider), std::uint8_t(mode), std::uint8_t(easing), 0,
+                     std::uint32_t(pathPoints.size()), std::uint32_t(points.size()), speed, phase});
+    pathPoints.insert(pathPoints.end(), points.begin(), points.end());
+}
+
+void LevelBuilder::addPickup(const WorldRect &rect)
+{
+    entities.push_back({std::uint32_t(EntityKind::Pickup), rect.left, rect.top, rect.width, rect.height,
+                        rect.left, rect.left, 0});
+}
+
+void LevelBuilder::addWalker(const WorldRect &rect, float minX, float maxX, float speed)
+{
+    entities.push_back({std::uint32_t(EntityKind::Walker), rect.left, rect.top, rect.width, rect.height,
+                        minX, maxX, speed});
+}
+
+std::vector<std::uint8_t> LevelBuilder::build() const
+{
+    const std::size_t n = colliders.size();
+    const std::uint32_t sectionCount = 6;
+
+    LevelSection sections[sectionCount];
+    std::size_t offset = sizeof(LevelHeader) + sizeof(sections);
+    sections[0] = {CollidersTag, std::uint32_t(offset), std::uint32_t(n), std::uint32_t(colliderSectionBytes(n))};
+    offset += sections[0].bytes;
+    sections[1] = {MoversTag, std::uint32_t(offset), std::uint32_t(movers.size()),
+                   std::uint32_t(movers.size() * sizeof(MoverRecord))};
+    offset += sections[1].bytes;
+    sections[2] = {DecorationTag, std::uint32_t(offset), 1, sizeof(Decoration)};
+    offset += sections[2].bytes;
+    sections[3] = {EntitiesTag, std::uint32_t(offset), std::uint32_t(entities.size()),
+                   std::uint32_t(entities.size() * sizeof(EntityRecord))};
+    offset += sections[3].bytes;
+    sections[4] = {PathsTag, std::uint32_t(offset), std::uint32_t(paths.size()),
+                   std::uint32_t(paths.size() * sizeof(PathRecord))};
+    offset += sections[4].bytes;
+    sections[5] = {PathPointsTag, std::uint32_t(offset), std::uint32_t(pathPoints.size()),
+                   std::uint32_t(pathPoints.size() * sizeof(PathPoint))};
+    offset += sections[5].bytes;
+
+    std::vector<std::uint8_t> image(offset, 0);
+    LevelHeader header = head;
+    header.sectionCount = sectionCount;
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(header), sections, sizeof(sections));
+
+    std::uint8_t *out = image.data() + sections[0].offset;
+    auto put = [&out](const void *src, std::size_t bytes) {
+        if (bytes)
+            std::memcpy(out, src, bytes);
+        out += bytes;
+    };
+    put(colliders.left.data(), n * sizeof(float));
+    put(colliders.top.data(), n * sizeof(float));
+    put(colliders.right.data(), n * sizeof(float));
+    put(colliders.bottom.data(), n * sizeof(float));
+    put(colliders.kind.data(), n);
+    put(colliders.style.data(), n);
+
+    if (!movers.empty())
+        std::memcpy(image.data() + sections[1].offset, movers.data(), sections[1].bytes);
+    std::memcpy(image.data() + sections[2].offset, &decor, sizeof(decor));
+    if (!entities.empty())
+        std::memcpy(image.data() + sections[3].offset, entities.data(), sections[3].bytes);
+    if (!paths.empty()) {
+        std::memcpy(image.data() + sections[4].offset, paths.data(), sections[4].bytes);
+        std::memcpy(image.data() + sections[5].offset, pathPoints.data(), sections[5].bytes);
+    }
+    return image;
+}
@@ -0,0 +1,194 @@
+#ifndef LEVELFORMAT_H
+#define LEVELFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "colliderstore.h"
+#include "entitystore.h"
+#include "kinematicpath.h"
+
+// Compiled level image. Levels are authored as JSON (see levels/) and
+// compiled into this little-endian binary form, which is read in place:
+// LevelView only validates offsets and hands out pointers into the buffer.
+//
+//   LevelHeader
+//   LevelSection[sectionCount]
+//   section payloads, each starting on a 4 byte boundary
+//
+// Colliders are stored structure-of-arrays exactly like ColliderStore, so
+// loading them is one bulk copy per array.
+namespace LevelFormat {
+
+constexpr std::uint32_t Magic = 0x314c564c; // "LVL1"
+constexpr std::uint32_t Version = 1;
+
+// Largest level LevelView accepts, in scene pixels. The broadphase grid,
+// the chunk map and the baked sky are sized from it, so a corrupt image
+// can't ask for gigabytes. Every other coordinate, offset, size and speed
+// must be finite and within MaxCoordinate of the origin.
+constexpr float MaxLevelWidth = 262144.0f;
+constexpr float MaxLevelHeight = 8192.0f;
+constexpr float MaxCoordinate = 1048576.0f;
+
+constexpr std::uint32_t tag(char a, char b, char c, char d)
+{
+    return std::uint32_t(std::uint8_t(a)) | std::uint32_t(std::uint8_t(b)) << 8
+         | std::uint32_t(std::uint8_t(c)) << 16 | std::uint32_t(std::uint8_t(d)) << 24;
+}
+
+// float left[n], top[n], right[n], bottom[n]; uint8 kind[n], style[n]
+constexpr std::uint32_t CollidersTag = tag('C', 'O', 'L', 'L');
+// MoverRecord[n]
+constexpr std::uint32_t MoversTag = tag('M', 'O', 'V', 'E');
+// Decoration[1]
+constexpr std::uint32_t DecorationTag = tag('D', 'E', 'C', 'O');
+// EntityRecord[n]; optional, older images have none
+constexpr std::uint32_t EntitiesTag = tag('E', 'N', 'T', 'S');
+// PathRecord[n] and the PathPoint[n] they index; optional
+constexpr std::uint32_t PathsTag = tag('P', 'A', 'T', 'H');
+constexpr std::uint32_t PathPointsTag = tag('P', 'N', 'T', 'S');
+
+struct LevelHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t sectionCount;
+    std::uint32_t reserved;
+    float width;
+    float height;
+    float spawnX;
+    float spawnY;
+};
+
+struct LevelSection
+{
+    std::uint32_t tag;
+    std::uint32_t offset; // from the start of the image
+    std::uint32_t count;  // records, or colliders for the collider section
+    std::uint32_t bytes;
+};
+
+struct MoverRecord
+{
+    std::uint32_t collider;
+    float minOffset;
+    float maxOffset;
+    float speed;
+};
+
+// Moving collider following waypoints given as offsets from its rect
+struct PathRecord
+{
+    std::uint32_t collider;
+    std::uint8_t mode;     // PathMode
+    std::uint8_t easing;   // PathEasing
+    std::uint16_t reserved;
+    std::uint32_t firstPoint;
+    std::uint32_t pointCount;
+    float speed;
+    float phase;
+};
+
+struct EntityRecord
+{
+    std::uint32_t kind;  // EntityKind, never Player
+    float left;
+    float top;
+    float width;
+    float height;
+    float minX;          // walker patrol range
+    float maxX;
+    float speed;
+};
+
+struct Decoration
+{
+    std::uint32_t skyTop;    // 0xAARRGGBB
+    std::uint32_t skyBottom;
+    std::uint32_t starCount;
+    float starMaxY;
+};
+
+} // namespace LevelFormat
+
+class LevelView
+{
+public:
+    // Validates the image; data must stay alive and unchanged while the view is used
+    bool parse(const void *data, std::size_t size);
+    const char *error() const { return lastError; }
+
+    const LevelFormat::LevelHeader &header() const { return *head; }
+
+    int colliderCount() const { return int(colliders); }
+    const float *left() const { return leftEdges; }
+    const float *top() const { return topEdges; }
+    const float *right() const { return rightEdges; }
+    const float *bottom() const { return bottomEdges; }
+    // ColliderKind and PlatformStyle values, range checked by parse()
+    const std::uint8_t *kinds() const { return kindTags; }
+    const std::uint8_t *styles() const { return styleTags; }
+
+    int moverCount() const { return int(moverRecords); }
+    const LevelFormat::MoverRecord *movers() const { return moverData; }
+
+    int pathCount() const { return int(pathRecords); }
+    const LevelFormat::PathRecord *paths() const { return pathData; }
+    const PathPoint *pathPoints() const { return pointData; }
+
+    int entityCount() const { return int(entityRecords); }
+    const LevelFormat::EntityRecord *entities() const { return entityData; }
+
+    const LevelFormat::Decoration &decoration() const { return decor; }
+
+private:
+    const LevelFormat::LevelHeader *head{nullptr};
+    std::uint32_t colliders{0};
+    const float *leftEdges{nullptr};
+    const float *topEdges{nullptr};
+    const float *rightEdges{nullptr};
+    const float *bottomEdges{nullptr};
+    const std::uint8_t *kindTags{nullptr};
+    const std::uint8_t *styleTags{nullptr};
+    std::uint32_t moverRecords{0};
+    const LevelFormat::MoverRecord *moverData{nullptr};
+    std::uint32_t pathRecords{0};
+    const LevelFormat::PathRecord *pathData{nullptr};
+    std::uint32_t pathPointCount{0};
+    const PathPoint *pointData{nullptr};
+    std::uint32_t entityRecords{0};
+    const LevelFormat::EntityRecord *entityData{nullptr};
+    LevelFormat::Decoration decor{};
+    const char *lastError{""};
+};
+
+// Writes level images; used by the JSON compiler and by code that generates levels
+class LevelBuilder
+{
+public:
+    void setBounds(float width, float height);
+    void setSpawn(float x, float y);
+    void setDecoration(const LevelFormat::Decoration &decoration);
+
+    int addCollider(const WorldRect &rect, ColliderKind kind, PlatformStyle style);
+    void addMover(const WorldRect &rect, float minOffset, float maxOffset, float speed);
+    void addSpikeRow(float x, float y, int count);
+    void addPath(const WorldRect &rect, const std::vector<PathPoint> &points, PathMode mode, PathEasing easing,
+                 float speed, float phase = 0);
+    void addPickup(const WorldRect &rect);
+    void addWalker(const WorldRect &rect, float minX, float maxX, float speed);
+
+    std::vector<std::uint8_t> build() const;
+
+private:
+    LevelFormat::LevelHeader head{LevelFormat::Magic, LevelFormat::Version, 0, 0, 800, 600, 0, 0};
+    ColliderStore colliders;
+    std::vector<LevelFormat::MoverRecord> movers;
+    std::vector<LevelFormat::PathRecord> paths;
+    std::vector<PathPoint> pathPoints;
+    std::vector<LevelFormat::EntityRecord> entities;
+    LevelFormat::Decoration decor{0xff1e1e3c, 0xff0a0a1e, 100, 300};
+};
+
+#endif // LEVELFORMAT_H
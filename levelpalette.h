@@ -0,0 +1,55 @@
+#ifndef LEVELPALETTE_H
+#define LEVELPALETTE_H
+
+#include <QBrush>
+#include <QColor>
+#include <QLinearGradient>
+#include <QPen>
+#include <QPolygonF>
+
+// Brushes, pens and shapes shared by every level item. Items keep implicitly
+// shared references to these, so building a level allocates no per-item
+// gradients or polygons.
+struct LevelPalette
+{
+    QBrush ground;
+    QBrush ledge;
+    QBrush mover{QColor(150, 100, 60)};
+    QBrush spike{QColor(200, 0, 0)};
+    QBrush coin{QColor(255, 200, 40)};
+    QBrush walker{QColor(170, 40, 60)};
+    QPen outline{QColor(70, 50, 30), 1};
+    // Particles, at full brightness
+    QColor dust{200, 185, 160, 200};
+    QColor spark{255, 120, 60};
+    QColor glow{170, 220, 255};
+    QColor star{255, 255, 255, 230};
+    QPolygonF spikeShape;
+
+    static const LevelPalette& instance()
+    {
+        static const LevelPalette palette;
+        return palette;
+    }
+
+private:
+    LevelPalette()
+    {
+        // Ground stretches to whatever it fills; the ledge gradient is 20 px
+        // from the top of the shape, so painters move the brush origin there
+        QLinearGradient groundGrad(0, 0, 0, 1);
+        groundGrad.setCoordinateMode(QGradient::ObjectBoundingMode);
+        groundGrad.setColorAt(0, QColor(80, 50, 30));
+        groundGrad.setColorAt(1, QColor(50, 30, 20));
+        ground = QBrush(groundGrad);
+
+        QLinearGradient platformGradient(0, 0, 0, 20);
+        platformGradient.setColorAt(0, QColor(120, 80, 50));
+        platformGradient.setColorAt(1, QColor(90, 60, 40));
+        ledge = QBrush(platformGradient);
+
+        spikeShape << QPointF(0, 20) << QPointF(10, 0) << QPointF(20, 20);
+    }
+};
+
+#endif // LEVELPALETTE_H
@@ -0,0 +1,104 @@
+#include "levelstreamer.h"
+#include "levelfile.h"
+#include "profiler.h"
+#include <QLinearGradient>
+#include <QPainter>
+#include <QtConcurrent/QtConcurrentRun>
+
+LevelStreamer::LevelStreamer(QObject *parent) : QObject(parent)
+{
+    connect(&watcher, &QFutureWatcherBase::finished, this, &LevelStreamer::onFinished);
+}
+
+LevelStreamer::~LevelStreamer()
+{
+    // The worker only touches its own PreparedLevel, but don't leave it running
+    watcher.waitForFinished();
+}
+
+std::shared_ptr<PreparedLevel> LevelStreamer::prepare(int levelNumber, double tickSeconds, std::uint32_t seed)
+{
+    ProfileScope scope("prepareLevel");
+    auto level = std::make_shared<PreparedLevel>();
+    level->number = levelNumber;
+    // Different levels of one session shouldn't share a star layout
+    level->seed = seed ^ (std::uint32_t(levelNumber) * 0x9e3779b9u);
+    LevelFile file;
+    if (!file.open(levelNumber)) {
+        level->error = file.errorString();
+        return level;
+    }
+
+    level->world.setTickRate(1.0 / tickSeconds);
+    level->world.loadLevel(file.view());
+    level->decoration = file.view().decoration();
+
+    level->background = bakeBackground(level->world, level->decoration);
+    return level;
+}
+
+QImage LevelStreamer::bakeBackground(const World &world, const LevelFormat::Decoration &decoration)
+{
+    QImage image(qBound(1, int(world.width), BackgroundTileWidth), qMax(1, int(world.height)),
+                 QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+
+    // Background with gradient
+    QLinearGradient bgGradient(0, 0, 0, world.height);
+    bgGradient.setColorAt(0, QColor::fromRgba(decoration.skyTop));
+    bgGradient.setColorAt(1, QColor::fromRgba(decoration.skyBottom));
+    painter.fillRect(image.rect(), bgGradient);
+    return image;
+}
+
+int LevelStreamer::nextLevel(int levelNumber)
+{
+    return LevelFile::exists(levelNumber + 1) ? levelNumber + 1 : 1;
+}
+
+void LevelStreamer::preload(int levelNumber, double tickSeconds)
+{
+    if (isReady(levelNumber))
+        return;
+    if (watcher.isRunning()) {
+        // Builds can't be interrupted, and waiting here would stall the
+        // frame; the newest request starts once the running build is done
+        queuedNumber = levelNumber == pendingNumber ? 0 : levelNumber;
+        queuedTickSeconds = tickSeconds;
+        return;
+    }
+    start(levelNumber, tickSeconds);
+}
+
+void LevelStreamer::start(int levelNumber, double tickSeconds)
+{
+    ready.reset();
+    pendingNumber = levelNumber;
+    queuedNumber = 0;
+    watcher.setFuture(QtConcurrent::run(&LevelStreamer::prepare, levelNumber, tickSeconds, sessionSeed));
+}
+
+bool LevelStreamer::isReady(int levelNumber) const
+{
+    return ready && ready->number == levelNumber;
+}
+
+std::shared_ptr<PreparedLevel> LevelStreamer::take(int levelNumber)
+{
+    if (!isReady(levelNumber))
+        return nullptr;
+    std::shared_ptr<PreparedLevel> level;
+    level.swap(ready);
+    return level;
+}
+
+void LevelStreamer::onFinished()
+{
+    // Nobody wants the level that just finished any more
+    if (queuedNumber) {
+        start(queuedNumber, queuedTickSeconds);
+        return;
+    }
+    ready = watcher.result();
+    emit levelReady(ready->number);
+}
@@ -0,0 +1,76 @@
+#ifndef LEVELSTREAMER_H
+#define LEVELSTREAMER_H
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <memory>
+#include "world.h"
+
+// Everything a level needs before it can be shown, built off the GUI thread.
+// Only the QGraphicsItems are left for the GUI thread to create.
+struct PreparedLevel
+{
+    int number{0};
+    std::uint32_t seed{0};  // star layout
+    World world;
+    LevelFormat::Decoration decoration{};
+    QImage background;  // sky, baked once
+    QString error;
+
+    bool isValid() const { return error.isEmpty(); }
+};
+
+// Builds levels on the global thread pool so switching scenes never parses,
+// compiles or bins colliders on the GUI thread. One level is prepared at a
+// time, normally the one after the level being played.
+class LevelStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LevelStreamer(QObject *parent = nullptr);
+    ~LevelStreamer();
+
+    // Synchronous build, also what the worker runs. The seed makes anything
+    // random about the level reproducible.
+    static std::shared_ptr<PreparedLevel> prepare(int levelNumber, double tickSeconds, std::uint32_t seed);
+
+    // Sky gradient for a level, which never changes while it plays; the
+    // stars twinkle, so the scene draws those. Levels wider than this repeat
+    // the image, so the baked sky costs the same however long a level is.
+    static constexpr int BackgroundTileWidth = 1024;
+    static QImage bakeBackground(const World &world, const LevelFormat::Decoration &decoration);
+
+    // Level to play after levelNumber; wraps back to the first level
+    static int nextLevel(int levelNumber);
+
+    // Session seed that preloaded levels are built with
+    void setSeed(std::uint32_t seed) { sessionSeed = seed; }
+
+    // Never blocks: while another level is still building, the request
+    // waits for it and levelReady() comes later
+    void preload(int levelNumber, double tickSeconds);
+    bool isReady(int levelNumber) const;
+    // Hands over a finished level, or nullptr if it isn't ready yet
+    std::shared_ptr<PreparedLevel> take(int levelNumber);
+
+signals:
+    void levelReady(int levelNumber);
+
+private slots:
+    void onFinished();
+
+private:
+    void start(int levelNumber, double tickSeconds);
+
+    QFutureWatcher<std::shared_ptr<PreparedLevel>> watcher;
+    std::shared_ptr<PreparedLevel> ready;
+    int pendingNumber{0};  // being built
+    int queuedNumber{0};   // to build next, 0 for none
+    double queuedTickSeconds{0};
+    std::uint32_t sessionSeed{0};
+};
+
+#endif // LEVELSTREAMER_H
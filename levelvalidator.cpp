@@ -0,0 +1,235 @@
+#include "levelvalidator.h"
+#include "levelfile.h"
+#include "profiler.h"
+#include "randomwalkbot.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+
+namespace {
+
+struct Run
+{
+    const InputJournal::Segment *segment{nullptr};  // bots have none
+    std::uint32_t seed{0};
+
+    bool completed{false};
+    std::uint64_t ticks{0};
+    std::vector<std::uint8_t> reached;
+    std::vector<DeathRecord> deaths;
+};
+
+void simulate(Run &run, const LevelView &level, const ValidationOptions &options, int columns, int rows)
+{
+    const double ticksPerSecond = run.segment ? run.segment->ticksPerSecond : options.ticksPerSecond;
+    World world;
+    world.setTickRate(ticksPerSecond);
+    world.loadLevel(level);
+    run.reached.assign(size_t(columns) * size_t(rows), 0);
+
+    // Returns true once the run is over
+    auto tick = [&](const PlayerInput &input) {
+        world.setInput(input.moveLeft, input.moveRight);
+        world.setRewinding(input.rewind);
+        if (input.jump)
+            world.requestJump(input.jumpPhase);
+        world.step();
+        const unsigned events = world.takeEvents();
+        if (events & World::PlayerDied)
+            run.deaths.push_back(world.lastDeath());
+
+        const PlayerState &p = world.player();
+        const int column = std::clamp(int((p.x + world.playerWidth / 2) / options.cellSize), 0, columns - 1);
+        const int row = std::clamp(int((p.y + world.playerHeight / 2) / options.cellSize), 0, rows - 1);
+        run.reached[size_t(row) * size_t(columns) + size_t(column)] = 1;
+
+        if (events & World::PlayerExited) {
+            run.completed = true;
+            return true;
+        }
+        return false;
+    };
+
+    if (run.segment) {
+        for (const InputJournal::InputRun &inputs : run.segment->runs) {
+            const PlayerInput input = InputJournal::unpack(inputs.bits);
+            for (std::uint32_t i = 0; i < inputs.length; ++i) {
+                if (tick(input)) {
+                    run.ticks = world.tick();
+                    return;
+                }
+            }
+        }
+    } else {
+        RandomWalkBot bot(run.seed);
+        const std::uint64_t maxTicks = std::uint64_t(options.secondsPerRun * ticksPerSecond);
+        for (std::uint64_t i = 0; i < maxTicks; ++i) {
+            if (tick(bot.next()))
+                break;
+        }
+    }
+    run.ticks = world.tick();
+}
+
+} // namespace
+
+int LevelReport::reachedCells() const
+{
+    return int(std::count(reached.begin(), reached.end(), 1));
+}
+
+int LevelReport::hazardDeaths() const
+{
+    return int(std::count_if(deaths.begin(), deaths.end(),
+                             [](const DeathRecord &death) { return death.cause == DeathCause::Hazard; }));
+}
+
+int LevelReport::falls() const
+{
+    return int(deaths.size()) - hazardDeaths();
+}
+
+LevelReport validateLevel(int levelNumber, const LevelView &level, const ValidationOptions &options,
+                          const std::vector<InputJournal::Segment> &recorded)
+{
+    LevelReport report;
+    report.level = levelNumber;
+    const LevelFormat::LevelHeader &header = level.header();
+    report.gridColumns = std::max(1, int(std::ceil(header.width / options.cellSize)));
+    report.gridRows = std::max(1, int(std::ceil(header.height / options.cellSize)));
+
+    std::vector<Run> runs(size_t(options.botRuns) + recorded.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (i < size_t(options.botRuns))
+            runs[i].seed = options.seed ^ (std::uint32_t(i) * 0x9e3779b9u) ^ std::uint32_t(levelNumber);
+        else
+            runs[i].segment = &recorded[i - size_t(options.botRuns)];
+    }
+
+    // Runs share the read-only level and the profiler's ring; callers that
+    // want them to scale turn the profiler off, as runValidation() does
+    QtConcurrent::blockingMap(runs, [&](Run &run) {
+        simulate(run, level, options, report.gridColumns, report.gridRows);
+    });
+
+    report.runs = int(runs.size());
+    report.reached.assign(size_t(report.gridColumns) * size_t(report.gridRows), 0);
+    std::vector<double> times;
+    for (const Run &run : runs) {
+        for (size_t cell = 0; cell < run.reached.size(); ++cell)
+            report.reached[cell] |= run.reached[cell];
+        report.deaths.insert(report.deaths.end(), run.deaths.begin(), run.deaths.end());
+        if (run.completed) {
+            const double tps = run.segment ? run.segment->ticksPerSecond : options.ticksPerSecond;
+            times.push_back(run.ticks / tps);
+        }
+    }
+
+    report.completions = int(times.size());
+    if (!times.empty()) {
+        std::sort(times.begin(), times.end());
+        report.fastestSeconds = times.front();
+        report.medianSeconds = times[times.size() / 2];
+    }
+    return report;
+}
+
+int runValidation(const QStringList &arguments)
+{
+    // Otherwise every worker's steps meet on the profiler's one ring, and
+    // the runs stop scaling with the cores
+    Profiler::instance().setEnabled(false);
+    QTextStream out(stdout);
+    ValidationOptions options;
+    std::vector<int> levels;
+    std::map<int, std::vector<InputJournal::Segment>> recorded;
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--runs" && hasValue) {
+            options.botRuns = qMax(0, arguments.at(++i).toInt());
+        } else if (argument == "--seconds" && hasValue) {
+            options.secondsPerRun = qMax(1.0, arguments.at(++i).toDouble());
+        } else if (argument == "--seed" && hasValue) {
+            options.seed = arguments.at(++i).toUInt();
+        } else if (argument.endsWith(".jrn")) {
+            InputJournal journal;
+            std::string error;
+            if (!journal.load(argument.toStdString(), &error)) {
+                out << argument << ": " << QString::fromStdString(error) << "\n";
+                return 1;
+            }
+            for (const InputJournal::Segment &segment : journal.segments())
+                recorded[segment.level].push_back(segment);
+        } else {
+            bool ok = false;
+            const int level = argument.toInt(&ok);
+            if (!ok || level < 1) {
+                out << "usage: --validate [--runs N] [--seconds S] [--seed S] [level | journal.jrn]...\n";
+                return 2;
+            }
+            levels.push_back(level);
+        }
+    }
+
+    if (levels.empty()) {
+        for (const auto &entry : recorded)
+            levels.push_back(entry.first);
+    }
+    if (levels.empty()) {
+        for (int level = 1; LevelFile::exists(level); ++level)
+            levels.push_back(level);
+    }
+
+    int failures = 0;
+    for (int number : levels) {
+        LevelFile file;
+        if (!file.open(number)) {
+            out << "Level " << number << ": " << file.errorString() << "\n";
+            ++failures;
+            continue;
+        }
+
+        QElapsedTimer clock;
+        clock.start();
+        const LevelReport report = validateLevel(number, file.view(), options, recorded[number]);
+        const double seconds = clock.nsecsElapsed() / 1e9;
+
+        const int cells = report.gridColumns * report.gridRows;
+        out << "Level " << number << ": " << report.runs << " runs in " << QString::number(seconds, 'f', 2)
+            << " s (" << QString::number(report.runs / qMax(seconds, 1e-9), 'f', 0) << " runs/s)\n";
+        if (report.completions) {
+            out << "  completed " << report.completions << "/" << report.runs << ", fastest "
+                << QString::number(report.fastestSeconds, 'f', 1) << " s, median "
+                << QString::number(report.medianSeconds, 'f', 1) << " s\n";
+        } else {
+            out << "  never completed\n";
+            ++failures;
+        }
+        out << "  reached " << report.reachedCells() << " of " << cells << " cells ("
+            << QString::number(100.0 * report.reachedCells() / cells, 'f', 1) << "%)\n";
+        out << "  deaths: " << report.hazardDeaths() << " on spikes, " << report.falls() << " falls\n";
+
+        // Deadliest spots, bucketed like the reachability grid
+        std::map<std::pair<int, int>, int> spots;
+        for (const DeathRecord &death : report.deaths) {
+            const int column = int(death.x / options.cellSize);
+            const int row = int(qMin(death.y, float(file.view().header().height)) / options.cellSize);
+            ++spots[{column, row}];
+        }
+        std::vector<std::pair<int, std::pair<int, int>>> ranked;
+        for (const auto &spot : spots)
+            ranked.push_back({spot.second, spot.first});
+        std::sort(ranked.rbegin(), ranked.rend());
+        for (size_t i = 0; i < ranked.size() && i < 5; ++i) {
+            out << "    " << ranked[i].first << " near (" << ranked[i].second.first * options.cellSize << ", "
+                << ranked[i].second.second * options.cellSize << ")\n";
+        }
+    }
+    return failures ? 1 : 0;
+}
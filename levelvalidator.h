@@ -0,0 +1,51 @@
+#ifndef LEVELVALIDATOR_H
+#define LEVELVALIDATOR_H
+
+#include <QStringList>
+#include <cstdint>
+#include <vector>
+#include "inputjournal.h"
+#include "world.h"
+
+class LevelView;
+
+struct ValidationOptions
+{
+    int botRuns{256};
+    double secondsPerRun{120};
+    std::uint32_t seed{1};
+    double ticksPerSecond{60};
+    float cellSize{32};  // reachability resolution
+};
+
+// What many headless runs of one level found out about it
+struct LevelReport
+{
+    int level{0};
+    int runs{0};
+    int completions{0};
+    double fastestSeconds{0};
+    double medianSeconds{0};    // of the runs that finished
+
+    int gridColumns{0};
+    int gridRows{0};
+    std::vector<std::uint8_t> reached;  // per cell, row major
+    int reachedCells() const;
+
+    std::vector<DeathRecord> deaths;
+    int hazardDeaths() const;
+    int falls() const;
+};
+
+// Runs botRuns random-walk bots plus every recorded segment on the global
+// thread pool. Every run owns its world; the level view is only read, so
+// runs scale with the number of cores.
+LevelReport validateLevel(int levelNumber, const LevelView &level, const ValidationOptions &options,
+                          const std::vector<InputJournal::Segment> &recorded = {});
+
+// Command line entry point for
+// --validate [--runs N] [--seconds S] [--seed S] [level | journal.jrn]...
+// Without levels every level in the pack is validated.
+int runValidation(const QStringList &arguments);
+
+#endif // LEVELVALIDATOR_H
@@ -0,0 +1,144 @@
+#include "loadgenerator.h"
+#include "netclient.h"
+#include "netserver.h"
+#include "randomwalkbot.h"
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+int runLoadGenerator(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    int clientCount = 32;
+    double seconds = 10;
+    int levelNumber = 1;
+    double rate = 60;
+    std::uint32_t seed = 1;
+    QString name = QString(NetProtocol::DefaultServerName) + "-loadgen";
+    bool external = false;
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--clients" && hasValue) {
+            clientCount = arguments.at(++i).toInt();
+        } else if (argument == "--seconds" && hasValue) {
+            seconds = arguments.at(++i).toDouble();
+        } else if (argument == "--level" && hasValue) {
+            levelNumber = arguments.at(++i).toInt();
+        } else if (argument == "--rate" && hasValue) {
+            rate = arguments.at(++i).toDouble();
+        } else if (argument == "--seed" && hasValue) {
+            seed = arguments.at(++i).toUInt();
+        } else if (argument == "--name" && hasValue) {
+            name = arguments.at(++i);
+        } else if (argument == "--external") {
+            external = true;
+        } else {
+            out << "usage: --loadgen [--clients N] [--seconds S] [--level L] [--rate R] [--seed S] "
+                   "[--name N] [--external]\n";
+            return 2;
+        }
+    }
+    if (clientCount < 1 || clientCount > NetProtocol::MaxPlayers || !(seconds > 0) || !(rate > 0)) {
+        out << "need 1 to " << NetProtocol::MaxPlayers << " clients and a positive duration and rate\n";
+        return 2;
+    }
+
+    // Hosted in this process unless told otherwise; the server keeps its
+    // own clock, so it runs the same either way
+    std::unique_ptr<NetServer> server;
+    if (!external) {
+        server.reset(new NetServer);
+        QString error;
+        if (!server->listen(name, levelNumber, rate, &error)) {
+            out << "cannot serve level " << levelNumber << ": " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<NetClient>> clients;
+    std::vector<RandomWalkBot> bots;
+    int failures = 0;
+    for (int i = 0; i < clientCount; ++i) {
+        clients.emplace_back(new NetClient);
+        bots.emplace_back(seed + std::uint32_t(i));
+        QObject::connect(clients.back().get(), &NetClient::failed, [&out, &failures, i](const QString &reason) {
+            out << "client " << i << ": " << reason << "\n";
+            ++failures;
+        });
+        clients.back()->connectToServer(name);
+    }
+
+    // Every bot plays one tick per tick of the server, paced the same way
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastNs = 0;
+    double accumulator = 0;
+    const double tickSeconds = 1.0 / rate;
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&ticker, &QTimer::timeout, [&] {
+        const qint64 now = clock.nsecsElapsed();
+        accumulator = std::min(accumulator + (now - lastNs) / 1e9, World::MaxStepsPerAdvance * tickSeconds);
+        lastNs = now;
+        for (; accumulator >= tickSeconds; accumulator -= tickSeconds) {
+            for (size_t i = 0; i < clients.size(); ++i)
+                clients[i]->step(bots[i].next());
+        }
+    });
+    ticker.start(std::max(1, int(1000.0 / rate)));
+
+    // A second to connect, then measure from a clean slate
+    QEventLoop loop;
+    QTimer::singleShot(1000, &loop, &QEventLoop::quit);
+    loop.exec();
+    for (const std::unique_ptr<NetClient> &client : clients)
+        client->resetStats();
+    if (server)
+        server->resetStats();
+    QTimer::singleShot(int(seconds * 1000), &loop, &QEventLoop::quit);
+    loop.exec();
+    ticker.stop();
+
+    int connected = 0;
+    NetClient::Stats sum;
+    for (const std::unique_ptr<NetClient> &client : clients) {
+        if (!client->isReady())
+            continue;
+        ++connected;
+        const NetClient::Stats &stats = client->stats();
+        sum.bytesSent += stats.bytesSent;
+        sum.bytesReceived += stats.bytesReceived;
+        sum.snapshots += stats.snapshots;
+        sum.bodyBytes += stats.bodyBytes;
+        sum.corrections += stats.corrections;
+        sum.resimulatedTicks += stats.resimulatedTicks;
+    }
+
+    out << connected << " of " << clientCount << " clients on level " << levelNumber << " at " << rate
+        << " ticks/s for " << seconds << " s\n";
+    if (connected > 0) {
+        const double perClient = double(connected) * seconds * 1024;
+        out << "  per client: " << QString::number(sum.bytesReceived / perClient, 'f', 2) << " KiB/s down, "
+            << QString::number(sum.bytesSent / perClient, 'f', 2) << " KiB/s up, snapshots at "
+            << QString::number(sum.bodyBytes ? 100.0 * sum.bytesReceived / sum.bodyBytes : 0, 'f', 1)
+            << "% of full size\n";
+        out << "  prediction: " << sum.corrections << " corrections in " << sum.snapshots << " snapshots, "
+            << QString::number(sum.snapshots ? double(sum.resimulatedTicks) / sum.snapshots : 0, 'f', 2)
+            << " ticks replayed per snapshot\n";
+    }
+    if (server) {
+        const NetServer::Stats stats = server->stats();
+        out << "  server: " << stats.ticks << " ticks, " << QString::number(stats.meanTickMs, 'f', 3)
+            << " ms mean, " << QString::number(stats.maxTickMs, 'f', 3) << " ms max per tick, "
+            << stats.starvedInputs << " inputs repeated for late clients\n";
+    }
+
+    for (const std::unique_ptr<NetClient> &client : clients)
+        client->disconnectFromServer();
+    return connected == clientCount && failures == 0 ? 0 : 1;
+}
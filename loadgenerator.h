@@ -0,0 +1,14 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QStringList>
+
+// Command line entry point for
+// --loadgen [--clients N] [--seconds S] [--level L] [--rate R] [--seed S] [--name N] [--external]
+// Connects N random-walk bots as network players, each predicting like a
+// real client, and reports bandwidth per client, prediction corrections
+// and, unless --external points it at a running --server, the server's
+// CPU time per tick.
+int runLoadGenerator(const QStringList &arguments);
+
+#endif // LOADGENERATOR_H
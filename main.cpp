@@ -1,10 +1,66 @@
 #include "mainwindow.h"
+#include "benchmarks.h"
+#include "levelcompiler.h"
+#include "levelvalidator.h"
+#include "loadgenerator.h"
+#include "netserver.h"
+#include "offscreenrenderer.h"
+#include "replay.h"
+#include "selftest.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Command line tools don't need a window
+    if (argc == 4 && qstrcmp(argv[1], "--compile-level") == 0) {
+        QCoreApplication app(argc, argv);
+        return compileLevelFile(app.arguments().at(2), app.arguments().at(3));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--replay") == 0) {
+        QCoreApplication app(argc, argv);
+        return runReplay(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--validate") == 0) {
+        QCoreApplication app(argc, argv);
+        return runValidation(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--selftest") == 0) {
+        QCoreApplication app(argc, argv);
+        return runSelfTest(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--server") == 0) {
+        QCoreApplication app(argc, argv);
+        return runServer(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--loadgen") == 0) {
+        QCoreApplication app(argc, argv);
+        return runLoadGenerator(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--bench") == 0) {
+        // Benchmarks render, but never need a screen
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        QApplication app(argc, argv);
+        return runBenchmarks(app.arguments().mid(2));
+    }
+
+    if (argc >= 2 && qstrcmp(argv[1], "--render") == 0) {
+        // Thumbnails, videos and golden images are all drawn offscreen
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        QApplication app(argc, argv);
+        return runRender(app.arguments().mid(2));
+    }
+
     QApplication a(argc, argv);
+
     MainWindow w;
     w.show();
     return a.exec();
@@ -5,13 +5,14 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
     // Create the game view and scene
-    view = new QGraphicsView(this);
     scene = new GameScene(this);
-    view->setScene(scene);
+    view = new GameView(scene, this);
     
     // Set up the view
     view->setRenderHint(QPainter::Antialiasing);
-    view->setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    // The scene's background is static, so keep it cached; GameView repaints
+    // only the rects the moving items touched (F2 cycles update modes)
+    view->setCacheMode(QGraphicsView::CacheBackground);
     view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     view->setFixedSize(800, 600);
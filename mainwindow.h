@@ -2,8 +2,8 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QGraphicsView>
 #include "gamescene.h"
+#include "gameview.h"
 
 class MainWindow : public QMainWindow
 {
@@ -14,7 +14,7 @@ public:
     ~MainWindow();
 
 private:
-    QGraphicsView* view;
+    GameView* view;
     GameScene* scene;
 };
 
@@ -1,4 +1,4 @@
-QT       += core gui widgets
+QT       += core gui widgets concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,13 +9,92 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    aabbkernel.cpp \
+    benchmarks.cpp \
+    chunkmap.cpp \
+    colliderstore.cpp \
+    deltacodec.cpp \
+    entitystore.cpp \
+    framescheduler.cpp \
+    framestreamwriter.cpp \
     gamescene.cpp \
+    gameview.cpp \
+    inputjournal.cpp \
+    kinematicpath.cpp \
+    latencyhistogram.cpp \
+    levelarena.cpp \
+    levelcompiler.cpp \
+    levelfile.cpp \
+    levelformat.cpp \
+    levelstreamer.cpp \
+    levelvalidator.cpp \
+    loadgenerator.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    netclient.cpp \
+    netprotocol.cpp \
+    netserver.cpp \
+    offscreenrenderer.cpp \
+    particleitem.cpp \
+    particlepool.cpp \
+    player.cpp \
+    profiler.cpp \
+    replay.cpp \
+    selftest.cpp \
+    rewindbuffer.cpp \
+    spatialgrid.cpp \
+    spriteatlas.cpp \
+    spriteitem.cpp \
+    sweptaabb.cpp \
+    tilelayeritem.cpp \
+    world.cpp
 
 HEADERS += \
+    aabbkernel.h \
+    benchmarks.h \
+    chunkmap.h \
+    colliderstore.h \
+    deltacodec.h \
+    entitystore.h \
+    framescheduler.h \
+    framestreamwriter.h \
     gamescene.h \
-    mainwindow.h
+    gameview.h \
+    inputjournal.h \
+    kinematicpath.h \
+    latencyhistogram.h \
+    levelarena.h \
+    levelcompiler.h \
+    levelfile.h \
+    levelformat.h \
+    levelpalette.h \
+    levelstreamer.h \
+    levelvalidator.h \
+    loadgenerator.h \
+    mainwindow.h \
+    netclient.h \
+    netprotocol.h \
+    netserver.h \
+    offscreenrenderer.h \
+    particleitem.h \
+    particlepool.h \
+    player.h \
+    profiler.h \
+    randomwalkbot.h \
+    replay.h \
+    rewindbuffer.h \
+    selftest.h \
+    spatialgrid.h \
+    spriteatlas.h \
+    spriteitem.h \
+    sweptaabb.h \
+    tilelayeritem.h \
+    world.h \
+    worldrect.h
+
+RESOURCES += \
+    anim.qrc \
+    levels.qrc
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -23,4 +102,8 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 DISTFILES += \
+    anim/kid.json \
+    levels/level1.json \
+    levels/level2.json \
+    levels/level3.json \
     milestone2.pro.user
@@ -0,0 +1,183 @@
+#include "netclient.h"
+#include "deltacodec.h"
+#include "inputjournal.h"
+#include <QLocalSocket>
+#include <QSignalBlocker>
+#include <cmath>
+#include <cstring>
+
+using namespace NetProtocol;
+
+NetClient::NetClient(QObject *parent) : QObject(parent)
+{
+    socket = new QLocalSocket(this);
+    connect(socket, &QLocalSocket::connected, this, [this] {
+        HelloMessage hello;
+        hello.version = Version;
+        outgoing.clear();
+        appendFrame(outgoing, MessageType::Hello, &hello, sizeof(hello));
+        socket->write(reinterpret_cast<const char *>(outgoing.data()), qint64(outgoing.size()));
+        totals.bytesSent += outgoing.size();
+    });
+    connect(socket, &QLocalSocket::readyRead, this, &NetClient::onReadyRead);
+    connect(socket, &QLocalSocket::disconnected, this, [this] { fail("server closed the connection"); });
+    connect(socket, &QLocalSocket::errorOccurred, this, [this] { fail(socket->errorString()); });
+}
+
+void NetClient::connectToServer(const QString &name)
+{
+    disconnectFromServer();
+    reader = FrameReader();
+    pending.clear();
+    sent = 0;
+    acknowledged = 0;
+    active = true;
+    socket->connectToServer(name);
+}
+
+void NetClient::disconnectFromServer()
+{
+    {
+        // Leaving isn't a failure
+        const QSignalBlocker blocker(socket);
+        socket->abort();
+    }
+    active = false;
+    welcomed = false;
+    if (ready) {
+        ready = false;
+        emit readyChanged(false);
+    }
+}
+
+void NetClient::fail(const QString &reason)
+{
+    // Only the first reason is worth reporting
+    if (!active)
+        return;
+    disconnectFromServer();
+    emit failed(reason);
+}
+
+void NetClient::step(const PlayerInput &input)
+{
+    if (!ready)
+        return;
+    // The server never rewinds, so neither does its prediction
+    PlayerInput played = input;
+    played.rewind = false;
+    apply(played);
+
+    InputMessage message;
+    std::memset(&message, 0, sizeof(message));
+    message.sequence = sent++;
+    message.bits = InputJournal::pack(played);
+    pending.push_back(message.bits);
+    outgoing.clear();
+    appendFrame(outgoing, MessageType::Input, &message, sizeof(message));
+    socket->write(reinterpret_cast<const char *>(outgoing.data()), qint64(outgoing.size()));
+    totals.bytesSent += outgoing.size();
+}
+
+void NetClient::apply(const PlayerInput &input)
+{
+    predicted.setInput(input.moveLeft, input.moveRight);
+    if (input.jump)
+        predicted.requestJump(input.jumpPhase);
+    predicted.step();
+    predicted.takeEvents();
+}
+
+void NetClient::onReadyRead()
+{
+    const QByteArray bytes = socket->readAll();
+    totals.bytesReceived += std::uint64_t(bytes.size());
+    reader.append(bytes.constData(), size_t(bytes.size()));
+
+    MessageType type;
+    const std::uint8_t *payload = nullptr;
+    std::size_t size = 0;
+    for (;;) {
+        const FrameReader::Result result = reader.next(type, payload, size);
+        if (result == FrameReader::Result::NeedMore)
+            return;
+        bool handled = false;
+        if (result == FrameReader::Result::Frame) {
+            if (type == MessageType::Welcome && !welcomed)
+                handled = handleWelcome(payload, size);
+            else if (type == MessageType::Snapshot && welcomed)
+                handled = handleSnapshot(payload, size);
+        }
+        if (!handled) {
+            fail("unexpected message from the server");
+            return;
+        }
+    }
+}
+
+bool NetClient::handleWelcome(const std::uint8_t *payload, std::size_t bytes)
+{
+    WelcomeMessage welcome;
+    if (bytes != sizeof(welcome))
+        return false;
+    std::memcpy(&welcome, payload, sizeof(welcome));
+    if (welcome.version != Version || welcome.slot >= std::uint32_t(MaxPlayers) || !(welcome.ticksPerSecond > 0))
+        return false;
+    if (!level.open(int(welcome.level))) {
+        fail(level.errorString());
+        return false;
+    }
+
+    // Built like the server builds it, or predictions can't match
+    predicted = World();
+    predicted.setTickRate(welcome.ticksPerSecond);
+    predicted.loadLevel(level.view());
+    if (predicted.stateSize() != welcome.stateBytes) {
+        fail("level " + QString::number(welcome.level) + " differs from the server's");
+        return false;
+    }
+    baseline.assign(snapshotBodySize(welcome.stateBytes), 0);
+    roster.assign(MaxPlayers, RemotePlayer());
+    ownSlot = int(welcome.slot);
+    welcomed = true;
+    return true;
+}
+
+bool NetClient::handleSnapshot(const std::uint8_t *payload, std::size_t bytes)
+{
+    SnapshotHeader header;
+    if (bytes < sizeof(header))
+        return false;
+    std::memcpy(&header, payload, sizeof(header));
+    if (header.bodyBytes != baseline.size() || header.deltaBytes != bytes - sizeof(header)
+        || header.inputsConsumed < acknowledged || header.inputsConsumed > sent)
+        return false;
+    if (!DeltaCodec::apply(payload + sizeof(header), header.deltaBytes, baseline.data(), baseline.size()))
+        return false;
+
+    // Inputs the server has run are in the state now
+    while (acknowledged < header.inputsConsumed) {
+        pending.pop_front();
+        ++acknowledged;
+    }
+    const std::size_t stateBytes = baseline.size() - roster.size() * sizeof(RemotePlayer);
+    std::memcpy(roster.data(), baseline.data() + stateBytes, roster.size() * sizeof(RemotePlayer));
+
+    // Start over from the server's state and predict the rest again
+    const PlayerState before = predicted.player();
+    predicted.restoreState(baseline.data());
+    for (std::uint8_t bits : pending)
+        apply(InputJournal::unpack(bits));
+    const PlayerState &after = predicted.player();
+
+    ++totals.snapshots;
+    totals.bodyBytes += header.bodyBytes;
+    totals.resimulatedTicks += pending.size();
+    if (ready && (std::abs(after.x - before.x) > 0.01f || std::abs(after.y - before.y) > 0.01f))
+        ++totals.corrections;
+    if (!ready) {
+        ready = true;
+        emit readyChanged(true);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef NETCLIENT_H
+#define NETCLIENT_H
+
+#include <QObject>
+#include <QString>
+#include <deque>
+#include <vector>
+#include "levelfile.h"
+#include "netprotocol.h"
+#include "world.h"
+
+class QLocalSocket;
+
+// Player of a NetServer session. Input is applied to a local copy of the
+// player's world straight away, so the player never waits on the server,
+// and sent along. Every snapshot restores the server's state, which has
+// seen a prefix of those inputs, and runs the rest again on top of it.
+// When client and server agree that lands where the prediction was.
+class NetClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetClient(QObject *parent = nullptr);
+
+    void connectToServer(const QString &name = NetProtocol::DefaultServerName);
+    void disconnectFromServer();
+    // Welcomed and holding the server's state
+    bool isReady() const { return ready; }
+
+    // Predicts one tick with this input and sends it to the server
+    void step(const PlayerInput &input);
+
+    const World &world() const { return predicted; }
+    int slot() const { return ownSlot; }
+    // Everyone on the server as of the last snapshot, own slot included
+    const std::vector<NetProtocol::RemotePlayer> &players() const { return roster; }
+
+    struct Stats
+    {
+        std::uint64_t bytesSent{0};
+        std::uint64_t bytesReceived{0};
+        std::uint64_t snapshots{0};
+        std::uint64_t bodyBytes{0};         // snapshot bodies after decoding
+        std::uint64_t corrections{0};       // snapshots that moved the player
+        std::uint64_t resimulatedTicks{0};  // inputs still in flight, per snapshot
+    };
+    const Stats &stats() const { return totals; }
+    void resetStats() { totals = Stats(); }
+
+signals:
+    void readyChanged(bool ready);
+    void failed(const QString &reason);
+
+private slots:
+    void onReadyRead();
+
+private:
+    bool handleWelcome(const std::uint8_t *payload, std::size_t bytes);
+    bool handleSnapshot(const std::uint8_t *payload, std::size_t bytes);
+    void fail(const QString &reason);
+    void apply(const PlayerInput &input);
+
+    QLocalSocket *socket{nullptr};
+    NetProtocol::FrameReader reader;
+    std::vector<std::uint8_t> outgoing;
+    bool active{false};  // connecting or connected
+    bool welcomed{false};
+    bool ready{false};
+    int ownSlot{-1};
+
+    LevelFile level;
+    World predicted;
+    // Inputs sent but not yet in a snapshot, oldest first
+    std::deque<std::uint8_t> pending;
+    std::uint32_t sent{0};
+    std::uint32_t acknowledged{0};
+    std::vector<std::uint8_t> baseline;  // last snapshot body
+    std::vector<NetProtocol::RemotePlayer> roster;
+
+    Stats totals;
+};
+
+#endif // NETCLIENT_H
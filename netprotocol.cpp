@@ -0,0 +1,53 @@
+#include "netprotocol.h"
+#include <cstring>
+
+namespace NetProtocol {
+
+void appendFrame(std::vector<std::uint8_t> &out, MessageType type, const void *payload, std::size_t bytes,
+                 const void *tail, std::size_t tailBytes)
+{
+    FrameHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.bytes = std::uint32_t(bytes + tailBytes);
+    header.type = std::uint8_t(type);
+
+    const std::size_t at = out.size();
+    out.resize(at + sizeof(header) + bytes + tailBytes);
+    std::memcpy(out.data() + at, &header, sizeof(header));
+    if (bytes)
+        std::memcpy(out.data() + at + sizeof(header), payload, bytes);
+    if (tailBytes)
+        std::memcpy(out.data() + at + sizeof(header) + bytes, tail, tailBytes);
+}
+
+void FrameReader::append(const void *data, std::size_t bytes)
+{
+    // Drop what was read before growing, so the buffer stays a frame or two
+    if (consumed > 0) {
+        buffer.erase(buffer.begin(), buffer.begin() + std::ptrdiff_t(consumed));
+        consumed = 0;
+    }
+    const std::uint8_t *begin = static_cast<const std::uint8_t *>(data);
+    buffer.insert(buffer.end(), begin, begin + bytes);
+}
+
+FrameReader::Result FrameReader::next(MessageType &type, const std::uint8_t *&payload, std::size_t &bytes)
+{
+    const std::size_t available = buffer.size() - consumed;
+    if (available < sizeof(FrameHeader))
+        return Result::NeedMore;
+    FrameHeader header;
+    std::memcpy(&header, buffer.data() + consumed, sizeof(header));
+    if (header.bytes > MaxPayloadBytes)
+        return Result::Broken;
+    if (available < sizeof(header) + header.bytes)
+        return Result::NeedMore;
+
+    type = MessageType(header.type);
+    payload = buffer.data() + consumed + sizeof(header);
+    bytes = header.bytes;
+    consumed += sizeof(header) + header.bytes;
+    return Result::Frame;
+}
+
+} // namespace NetProtocol
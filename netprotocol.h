@@ -0,0 +1,117 @@
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Messages between the game server and its clients. Sockets carry a stream
+// of frames, little endian like the level format:
+//
+//   FrameHeader, then bytes of payload
+//
+// A client says Hello and gets a Welcome naming its player slot and the
+// level. From then on it sends one Input per tick it predicts, numbered from
+// zero, and the server answers every tick it runs with a Snapshot.
+//
+// A snapshot body is the client's own world state block (World::saveState)
+// followed by a RemotePlayer for every slot. It goes out as a DeltaCodec
+// delta against the body sent before it, which both ends keep; the first is
+// against zeros. Sockets are reliable and ordered, so nothing is acked.
+namespace NetProtocol {
+
+constexpr std::uint32_t Version = 1;
+constexpr int MaxPlayers = 64;
+constexpr const char *DefaultServerName = "level4-server";
+// Anything bigger is a broken stream rather than a message
+constexpr std::uint32_t MaxPayloadBytes = 1 << 20;
+
+enum class MessageType : std::uint8_t
+{
+    Hello = 1,     // client -> server: HelloMessage
+    Welcome = 2,   // server -> client: WelcomeMessage
+    Input = 3,     // client -> server: InputMessage
+    Snapshot = 4   // server -> client: SnapshotHeader, then the delta
+};
+
+struct FrameHeader
+{
+    std::uint32_t bytes;  // payload only
+    std::uint8_t type;    // MessageType
+    std::uint8_t reserved[3];
+};
+
+struct HelloMessage
+{
+    std::uint32_t version;
+};
+
+struct WelcomeMessage
+{
+    std::uint32_t version;
+    std::uint32_t slot;
+    std::uint32_t level;
+    float ticksPerSecond;
+    std::uint32_t stateBytes;  // World::stateSize() of the level
+};
+
+struct InputMessage
+{
+    std::uint32_t sequence;
+    std::uint8_t bits;  // InputJournal::pack
+    std::uint8_t reserved[3];
+};
+
+struct SnapshotHeader
+{
+    std::uint32_t serverTick;
+    std::uint32_t inputsConsumed;  // inputs the state block has seen
+    std::uint32_t bodyBytes;       // decoded
+    std::uint32_t deltaBytes;      // encoded, following this header
+};
+
+enum RemotePlayerFlags : std::uint8_t {
+    PlayerConnected = 1 << 0,
+    PlayerJumping = 1 << 1
+};
+
+struct RemotePlayer
+{
+    float x;
+    float y;
+    std::uint8_t flags;  // RemotePlayerFlags
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(FrameHeader) == 8, "frames must stay packed");
+static_assert(sizeof(InputMessage) == 8, "inputs must stay packed");
+static_assert(sizeof(SnapshotHeader) == 16, "snapshots must stay packed");
+static_assert(sizeof(RemotePlayer) == 12, "players must stay packed");
+
+inline std::size_t snapshotBodySize(std::size_t stateBytes)
+{
+    return stateBytes + MaxPlayers * sizeof(RemotePlayer);
+}
+
+// Appends a frame with the given payload parts to out
+void appendFrame(std::vector<std::uint8_t> &out, MessageType type, const void *payload, std::size_t bytes,
+                 const void *tail = nullptr, std::size_t tailBytes = 0);
+
+// Cuts the incoming byte stream back into frames
+class FrameReader
+{
+public:
+    void append(const void *data, std::size_t bytes);
+    // Takes the next complete frame; payload points into the reader and is
+    // valid until the next append(). Fails on frames too big to be ours.
+    enum class Result { Frame, NeedMore, Broken };
+    Result next(MessageType &type, const std::uint8_t *&payload, std::size_t &bytes);
+
+private:
+    std::vector<std::uint8_t> buffer;
+    std::size_t consumed{0};
+};
+
+} // namespace NetProtocol
+
+#endif // NETPROTOCOL_H
@@ -0,0 +1,330 @@
+#include "netserver.h"
+#include "deltacodec.h"
+#include "inputjournal.h"
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <cstring>
+
+using namespace NetProtocol;
+
+NetServer::NetServer(QObject *parent) : QObject(parent)
+{
+    server = new QLocalServer(this);
+    connect(server, &QLocalServer::newConnection, this, &NetServer::onNewConnection);
+
+    // Wakes up about once a tick and runs however many ticks are due, so
+    // the tick rate holds on average whatever the timer granularity
+    timer = new QTimer(this);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &NetServer::runTicks);
+
+    players.resize(MaxPlayers);
+    roster.assign(MaxPlayers, RemotePlayer());
+}
+
+NetServer::~NetServer()
+{
+    close();
+}
+
+bool NetServer::listen(const QString &name, int number, double ticksPerSecond, QString *error)
+{
+    close();
+    if (!level.open(number)) {
+        if (error)
+            *error = level.errorString();
+        return false;
+    }
+    // A server that crashed leaves its socket file behind
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        if (error)
+            *error = server->errorString();
+        return false;
+    }
+
+    levelNumber = number;
+    clockWorld = World();
+    // Clients get the rate as a float and must step exactly like this
+    clockWorld.setTickRate(float(ticksPerSecond));
+    clockWorld.loadLevel(level.view());
+    std::fill(roster.begin(), roster.end(), RemotePlayer());
+    delta.assign(DeltaCodec::maxEncodedSize(snapshotBodySize(clockWorld.stateSize())), 0);
+    resetStats();
+
+    clock.start();
+    lastNs = 0;
+    accumulator = 0;
+    timer->start(std::max(1, int(1000.0 / ticksPerSecond)));
+    return true;
+}
+
+void NetServer::close()
+{
+    timer->stop();
+    for (std::unique_ptr<Player> &player : players) {
+        if (player)
+            dropPlayer(player.get());
+    }
+    server->close();
+}
+
+NetServer::Stats NetServer::stats() const
+{
+    Stats result = totals;
+    result.players = int(std::count_if(players.begin(), players.end(),
+                                       [](const std::unique_ptr<Player> &player) { return player != nullptr; }));
+    result.meanTickMs = totals.ticks ? tickMsSum / double(totals.ticks) : 0;
+    return result;
+}
+
+void NetServer::resetStats()
+{
+    totals = Stats();
+    tickMsSum = 0;
+}
+
+void NetServer::onNewConnection()
+{
+    while (server->hasPendingConnections()) {
+        QLocalSocket *socket = server->nextPendingConnection();
+        auto free = std::find(players.begin(), players.end(), nullptr);
+        if (free == players.end()) {
+            // Full; closing is the answer
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        const int slot = int(free - players.begin());
+        std::unique_ptr<Player> player(new Player);
+        player->socket = socket;
+        player->slot = slot;
+        *free = std::move(player);
+        connect(socket, &QLocalSocket::readyRead, this, [this, slot] {
+            if (players[size_t(slot)])
+                readPlayer(*players[size_t(slot)]);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, slot] {
+            if (players[size_t(slot)])
+                dropPlayer(players[size_t(slot)].get());
+        });
+    }
+}
+
+void NetServer::readPlayer(Player &player)
+{
+    const QByteArray bytes = player.socket->readAll();
+    totals.bytesReceived += std::uint64_t(bytes.size());
+    player.reader.append(bytes.constData(), size_t(bytes.size()));
+
+    MessageType type;
+    const std::uint8_t *payload = nullptr;
+    std::size_t size = 0;
+    for (;;) {
+        const FrameReader::Result result = player.reader.next(type, payload, size);
+        if (result == FrameReader::Result::NeedMore)
+            return;
+        if (result == FrameReader::Result::Broken) {
+            dropPlayer(&player);
+            return;
+        }
+
+        if (type == MessageType::Hello && !player.welcomed && size == sizeof(HelloMessage)) {
+            HelloMessage hello;
+            std::memcpy(&hello, payload, sizeof(hello));
+            if (hello.version != Version) {
+                dropPlayer(&player);
+                return;
+            }
+            // Joins on the current tick, where everyone else is
+            player.world = clockWorld;
+            player.welcomed = true;
+            player.baseline.assign(snapshotBodySize(player.world.stateSize()), 0);
+
+            WelcomeMessage welcome;
+            std::memset(&welcome, 0, sizeof(welcome));
+            welcome.version = Version;
+            welcome.slot = std::uint32_t(player.slot);
+            welcome.level = std::uint32_t(levelNumber);
+            welcome.ticksPerSecond = float(1.0 / clockWorld.tickSeconds());
+            welcome.stateBytes = std::uint32_t(player.world.stateSize());
+            player.outgoing.clear();
+            appendFrame(player.outgoing, MessageType::Welcome, &welcome, sizeof(welcome));
+            player.socket->write(reinterpret_cast<const char *>(player.outgoing.data()),
+                                 qint64(player.outgoing.size()));
+            totals.bytesSent += player.outgoing.size();
+        } else if (type == MessageType::Input && player.welcomed && size == sizeof(InputMessage)) {
+            InputMessage input;
+            std::memcpy(&input, payload, sizeof(input));
+            // Streams are ordered, so a gap means the client is broken
+            if (input.sequence != player.consumed + player.inputs.size()) {
+                dropPlayer(&player);
+                return;
+            }
+            player.inputs.push_back(input.bits);
+            if (player.inputs.size() > MaxQueuedInputs) {
+                player.inputs.pop_front();
+                ++player.consumed;
+            }
+        } else {
+            dropPlayer(&player);
+            return;
+        }
+    }
+}
+
+void NetServer::dropPlayer(Player *player)
+{
+    const int slot = player->slot;
+    player->socket->disconnect(this);
+    player->socket->abort();
+    player->socket->deleteLater();
+    roster[size_t(slot)] = RemotePlayer();
+    players[size_t(slot)].reset();
+}
+
+void NetServer::runTicks()
+{
+    const qint64 now = clock.nsecsElapsed();
+    const double tickSeconds = clockWorld.tickSeconds();
+    accumulator = std::min(accumulator + (now - lastNs) / 1e9, World::MaxStepsPerAdvance * tickSeconds);
+    lastNs = now;
+    while (accumulator >= tickSeconds) {
+        step();
+        accumulator -= tickSeconds;
+    }
+}
+
+void NetServer::step()
+{
+    QElapsedTimer cost;
+    cost.start();
+
+    clockWorld.step();
+    clockWorld.takeEvents();
+    for (std::unique_ptr<Player> &player : players) {
+        if (!player || !player->welcomed)
+            continue;
+        PlayerInput input = player->last;
+        input.jump = false;
+        if (!player->inputs.empty()) {
+            input = InputJournal::unpack(player->inputs.front());
+            player->inputs.pop_front();
+            ++player->consumed;
+        } else {
+            ++totals.starvedInputs;
+        }
+        // Rewinding is for playing alone
+        input.rewind = false;
+        player->last = input;
+
+        World &world = player->world;
+        world.setInput(input.moveLeft, input.moveRight);
+        if (input.jump)
+            world.requestJump(input.jumpPhase);
+        world.step();
+        world.takeEvents();
+
+        RemotePlayer &entry = roster[size_t(player->slot)];
+        entry.x = world.player().x;
+        entry.y = world.player().y;
+        entry.flags = PlayerConnected | (world.player().isJumping ? PlayerJumping : 0);
+    }
+    sendSnapshots();
+
+    const double ms = cost.nsecsElapsed() / 1e6;
+    ++totals.ticks;
+    tickMsSum += ms;
+    totals.maxTickMs = std::max(totals.maxTickMs, ms);
+}
+
+void NetServer::sendSnapshots()
+{
+    for (std::unique_ptr<Player> &player : players) {
+        if (!player || !player->welcomed)
+            continue;
+        const World &world = player->world;
+        const std::size_t stateBytes = world.stateSize();
+        const std::size_t bodyBytes = snapshotBodySize(stateBytes);
+        player->body.resize(bodyBytes);
+        world.saveState(player->body.data());
+        std::memcpy(player->body.data() + stateBytes, roster.data(), roster.size() * sizeof(RemotePlayer));
+
+        // XOR against what the client holds at the back of the buffer, then
+        // encode it forwards over itself
+        std::uint8_t *changes = delta.data() + (delta.size() - bodyBytes);
+        for (std::size_t i = 0; i < bodyBytes; ++i)
+            changes[i] = player->body[i] ^ player->baseline[i];
+        const std::size_t encoded = DeltaCodec::encode(changes, bodyBytes, delta.data());
+
+        SnapshotHeader header;
+        header.serverTick = std::uint32_t(clockWorld.tick());
+        header.inputsConsumed = player->consumed;
+        header.bodyBytes = std::uint32_t(bodyBytes);
+        header.deltaBytes = std::uint32_t(encoded);
+        player->outgoing.clear();
+        appendFrame(player->outgoing, MessageType::Snapshot, &header, sizeof(header), delta.data(), encoded);
+        player->socket->write(reinterpret_cast<const char *>(player->outgoing.data()),
+                              qint64(player->outgoing.size()));
+        player->baseline.swap(player->body);
+
+        totals.bytesSent += player->outgoing.size();
+        totals.bodyBytes += bodyBytes;
+    }
+}
+
+int runServer(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    QString name = DefaultServerName;
+    int levelNumber = 1;
+    double rate = 60;
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--name" && hasValue) {
+            name = arguments.at(++i);
+        } else if (argument == "--level" && hasValue) {
+            levelNumber = arguments.at(++i).toInt();
+        } else if (argument == "--rate" && hasValue) {
+            rate = arguments.at(++i).toDouble();
+        } else {
+            out << "usage: --server [--name N] [--level L] [--rate R]\n";
+            return 2;
+        }
+    }
+    if (!(rate > 0)) {
+        out << "tick rate must be positive\n";
+        return 2;
+    }
+
+    NetServer server;
+    QString error;
+    if (!server.listen(name, levelNumber, rate, &error)) {
+        out << "cannot serve level " << levelNumber << " as " << name << ": " << error << "\n";
+        return 1;
+    }
+    out << "Serving level " << levelNumber << " as " << name << " at " << rate << " ticks/s\n";
+    out.flush();
+
+    constexpr int ReportSeconds = 5;
+    QTimer report;
+    QObject::connect(&report, &QTimer::timeout, [&] {
+        const NetServer::Stats stats = server.stats();
+        const double perPlayer = stats.players ? double(stats.bytesSent) / stats.players / ReportSeconds : 0;
+        out << stats.players << " players, tick " << QString::number(stats.meanTickMs, 'f', 3) << " ms mean "
+            << QString::number(stats.maxTickMs, 'f', 3) << " ms max, "
+            << QString::number(perPlayer / 1024, 'f', 1) << " KiB/s per player, snapshots at "
+            << QString::number(stats.bodyBytes ? 100.0 * stats.bytesSent / stats.bodyBytes : 0, 'f', 1)
+            << "% of full size\n";
+        out.flush();
+        server.resetStats();
+    });
+    report.start(ReportSeconds * 1000);
+    return QCoreApplication::exec();
+}
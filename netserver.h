@@ -0,0 +1,103 @@
+#ifndef NETSERVER_H
+#define NETSERVER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "levelfile.h"
+#include "netprotocol.h"
+#include "world.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+
+// Authoritative simulation for several players on one level, served over
+// local sockets. Players don't touch each other, so each one is simulated
+// by a world of its own; all of them step in lockstep with a world nobody
+// plays, which a joining player's world is copied from. That way every
+// world has the same tick, movers and walkers, and the single-player world
+// stays exactly what replays and the validator check.
+//
+// Each tick takes one queued input per player (repeating the last one when
+// a client falls behind) and sends every player a delta snapshot.
+class NetServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetServer(QObject *parent = nullptr);
+    ~NetServer();
+
+    bool listen(const QString &name, int number, double ticksPerSecond, QString *error = nullptr);
+    void close();
+
+    // Inputs queued beyond this are dropped as if they'd been run, so a
+    // client that bursts can't build up latency
+    static constexpr std::size_t MaxQueuedInputs = 8;
+
+    struct Stats
+    {
+        int players{0};
+        std::uint64_t ticks{0};
+        double meanTickMs{0};  // simulating and encoding, all players
+        double maxTickMs{0};
+        std::uint64_t bytesSent{0};
+        std::uint64_t bytesReceived{0};
+        std::uint64_t bodyBytes{0};     // snapshot bodies before delta coding
+        std::uint64_t starvedInputs{0}; // ticks run on a repeated input
+    };
+    Stats stats() const;
+    void resetStats();
+
+private slots:
+    void onNewConnection();
+    void runTicks();
+
+private:
+    struct Player
+    {
+        QLocalSocket *socket{nullptr};
+        int slot{-1};
+        bool welcomed{false};
+        World world;
+        NetProtocol::FrameReader reader;
+        std::deque<std::uint8_t> inputs;
+        std::uint32_t consumed{0};
+        PlayerInput last;
+        std::vector<std::uint8_t> baseline;  // body the client holds
+        std::vector<std::uint8_t> body;
+        std::vector<std::uint8_t> outgoing;
+    };
+
+    void readPlayer(Player &player);
+    void dropPlayer(Player *player);
+    void step();
+    void sendSnapshots();
+
+    QLocalServer *server{nullptr};
+    QTimer *timer{nullptr};
+    QElapsedTimer clock;
+    qint64 lastNs{0};
+    double accumulator{0};
+
+    LevelFile level;
+    int levelNumber{0};
+    World clockWorld;
+    std::vector<std::unique_ptr<Player>> players;  // by slot, null when free
+    std::vector<NetProtocol::RemotePlayer> roster;
+    std::vector<std::uint8_t> delta;
+
+    Stats totals;
+    double tickMsSum{0};
+};
+
+// Command line entry point for --server [--name N] [--level L] [--rate R];
+// runs until killed and prints its load every few seconds
+int runServer(const QStringList &arguments);
+
+#endif // NETSERVER_H
@@ -0,0 +1,259 @@
+#include "offscreenrenderer.h"
+#include "framestreamwriter.h"
+#include "gamescene.h"
+#include "inputjournal.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPainter>
+#include <QTextStream>
+#include <cstdlib>
+
+OffscreenRenderer::OffscreenRenderer(GameScene *renderScene, const QSize &outputSize)
+    : scene(renderScene),
+    size(outputSize.isEmpty() ? renderScene->camera().size().toSize() : outputSize),
+    frame(size, QImage::Format_RGB32)
+{
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    stopStream();
+}
+
+bool OffscreenRenderer::startStream(const QString &path, QString *error)
+{
+    stopStream();
+    std::unique_ptr<FrameStreamWriter> writer(new FrameStreamWriter(size));
+    if (!writer->open(path, error))
+        return false;
+    stream = std::move(writer);
+    frame = stream->acquire();
+    pending = false;
+    return true;
+}
+
+bool OffscreenRenderer::stopStream(QString *error)
+{
+    if (!stream)
+        return true;
+    if (pending)
+        stream->submit(std::move(frame));
+    pending = false;
+    const bool ok = stream->close(error);
+    stream.reset();
+    // The pool is gone with the writer; keep rendering into a buffer of our own
+    frame = QImage(size, QImage::Format_RGB32);
+    return ok;
+}
+
+const QImage &OffscreenRenderer::render()
+{
+    if (stream && pending) {
+        // The last frame is the writer's now; paint into the next free one
+        stream->submit(std::move(frame));
+        frame = stream->acquire();
+    }
+    pending = bool(stream);
+
+    // Letterbox when the aspect ratios differ
+    frame.fill(Qt::black);
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing);
+    scene->render(&painter, QRectF(frame.rect()), scene->camera());
+    return frame;
+}
+
+ImageComparison compareImages(const QImage &actual, const QImage &expected, int tolerance)
+{
+    ImageComparison result;
+    result.sameSize = actual.size() == expected.size();
+    if (!result.sameSize)
+        return result;
+
+    // No copies when both are RGB32 already, which rendered frames are
+    const QImage a = actual.convertToFormat(QImage::Format_RGB32);
+    const QImage b = expected.convertToFormat(QImage::Format_RGB32);
+    result.pixels = qint64(a.width()) * a.height();
+    result.diff = QImage(a.size(), QImage::Format_RGB32);
+    for (int y = 0; y < a.height(); ++y) {
+        const QRgb *rowA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb *rowB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        QRgb *out = reinterpret_cast<QRgb *>(result.diff.scanLine(y));
+        for (int x = 0; x < a.width(); ++x) {
+            const int delta = qMax(qMax(std::abs(qRed(rowA[x]) - qRed(rowB[x])),
+                                        std::abs(qGreen(rowA[x]) - qGreen(rowB[x]))),
+                                   std::abs(qBlue(rowA[x]) - qBlue(rowB[x])));
+            result.maxDelta = qMax(result.maxDelta, delta);
+            if (delta > tolerance) {
+                ++result.differingPixels;
+                out[x] = qRgb(255, 0, 0);
+            } else {
+                out[x] = qRgb(qRed(rowA[x]) / 3, qGreen(rowA[x]) / 3, qBlue(rowA[x]) / 3);
+            }
+        }
+    }
+    return result;
+}
+
+int runRender(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    int level = 1;
+    std::uint32_t seed = 1;
+    int frames = -1;
+    double fps = 60;
+    QSize size;
+    QString journalPath, pngPath, streamPath, goldenPath;
+    int tolerance = 8;
+    double allowed = 0.001;
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--level" && hasValue) {
+            level = qMax(1, arguments.at(++i).toInt());
+        } else if (argument == "--seed" && hasValue) {
+            seed = arguments.at(++i).toUInt();
+        } else if (argument == "--frames" && hasValue) {
+            frames = qMax(1, arguments.at(++i).toInt());
+        } else if (argument == "--fps" && hasValue) {
+            fps = qMax(1.0, arguments.at(++i).toDouble());
+        } else if (argument == "--size" && hasValue) {
+            const QStringList parts = arguments.at(++i).split('x');
+            if (parts.size() == 2)
+                size = QSize(parts.at(0).toInt(), parts.at(1).toInt());
+        } else if (argument == "--journal" && hasValue) {
+            journalPath = arguments.at(++i);
+        } else if (argument == "--png" && hasValue) {
+            pngPath = arguments.at(++i);
+        } else if (argument == "--stream" && hasValue) {
+            streamPath = arguments.at(++i);
+        } else if (argument == "--golden" && hasValue) {
+            goldenPath = arguments.at(++i);
+        } else if (argument == "--tolerance" && hasValue) {
+            tolerance = qBound(0, arguments.at(++i).toInt(), 255);
+        } else if (argument == "--allow" && hasValue) {
+            allowed = qBound(0.0, arguments.at(++i).toDouble(), 1.0);
+        } else {
+            out << "usage: --render [--level N | --journal file.jrn] [--seed S] [--frames N] [--fps F]\n"
+                   "                [--size WxH] [--png out.png] [--stream out.raw]\n"
+                   "                [--golden ref.png] [--tolerance T] [--allow fraction]\n";
+            return 2;
+        }
+    }
+
+    // Inputs for every tick, if we're replaying a session
+    std::vector<std::uint8_t> inputs;
+    if (!journalPath.isEmpty()) {
+        InputJournal journal;
+        std::string error;
+        if (!journal.load(journalPath.toStdString(), &error)) {
+            out << journalPath << ": " << QString::fromStdString(error) << "\n";
+            return 1;
+        }
+        if (journal.segments().empty()) {
+            out << journalPath << ": no segments\n";
+            return 1;
+        }
+        for (const InputJournal::Segment &segment : journal.segments()) {
+            if (qAbs(segment.ticksPerSecond * World::ReferenceTickSeconds - 1.0) > 1e-6) {
+                out << journalPath << ": recorded at " << segment.ticksPerSecond << " ticks/s, can only render "
+                    << 1.0 / World::ReferenceTickSeconds << "\n";
+                return 1;
+            }
+            for (const InputJournal::InputRun &run : segment.runs)
+                inputs.insert(inputs.end(), run.length, run.bits);
+        }
+        level = journal.segments().front().level;
+        seed = journal.seed();
+    }
+
+    GameScene scene;
+    scene.frameScheduler()->stop();
+    scene.setBlockingLoads(true);
+    scene.restart(level, seed);
+
+    const double tickSeconds = World::ReferenceTickSeconds;
+    const double frameSeconds = 1.0 / fps;
+    if (frames < 0)
+        frames = inputs.empty() ? 1 : int(inputs.size() * tickSeconds / frameSeconds) + 1;
+
+    OffscreenRenderer renderer(&scene, size);
+    QString error;
+    if (!streamPath.isEmpty() && !renderer.startStream(streamPath, &error)) {
+        out << streamPath << ": " << error << "\n";
+        return 1;
+    }
+
+    // The world steps one tick at a time so journal input lands on the tick
+    // it was recorded on; a frame is taken whenever a frame's worth of
+    // simulated time has passed
+    QElapsedTimer clock;
+    clock.start();
+    size_t tick = 0;
+    double nextFrame = 0;
+    int rendered = 0;
+    QImage last;
+    while (rendered < frames) {
+        if (tick * tickSeconds >= nextFrame - 1e-9) {
+            const QImage &image = renderer.render();
+            // Sharing the buffer makes the renderer allocate a new one, so only once
+            if (++rendered == frames)
+                last = image;
+            nextFrame += frameSeconds;
+            continue;
+        }
+        scene.setInput(tick < inputs.size() ? InputJournal::unpack(inputs[tick]) : PlayerInput());
+        scene.step(tickSeconds);
+        ++tick;
+    }
+    const double seconds = clock.nsecsElapsed() / 1e9;
+
+    int failures = 0;
+    if (!renderer.stopStream(&error)) {
+        out << streamPath << ": " << error << "\n";
+        ++failures;
+    }
+
+    out << "Rendered " << rendered << " frames of " << renderer.frameSize().width() << "x"
+        << renderer.frameSize().height() << " (" << tick << " ticks) in " << QString::number(seconds, 'f', 2)
+        << " s, " << QString::number(rendered / qMax(seconds, 1e-9), 'f', 0) << " frames/s\n";
+    if (!streamPath.isEmpty())
+        out << "Stream: ffmpeg -f rawvideo -pixel_format bgra -video_size " << renderer.frameSize().width() << "x"
+            << renderer.frameSize().height() << " -framerate " << fps << " -i " << streamPath << " out.mp4\n";
+
+    if (!pngPath.isEmpty() && !last.save(pngPath)) {
+        out << pngPath << ": cannot write\n";
+        ++failures;
+    }
+
+    if (!goldenPath.isEmpty()) {
+        const QImage golden(goldenPath);
+        if (golden.isNull()) {
+            // First run records the reference that later runs are held to
+            if (!last.save(goldenPath)) {
+                out << goldenPath << ": cannot write\n";
+                return 1;
+            }
+            out << "Golden: recorded " << goldenPath << "\n";
+        } else {
+            const ImageComparison comparison = compareImages(last, golden, tolerance);
+            if (comparison.matches(allowed)) {
+                out << "Golden: match (" << comparison.differingPixels << " pixels over tolerance, max delta "
+                    << comparison.maxDelta << ")\n";
+            } else if (!comparison.sameSize) {
+                out << "Golden: size differs from " << goldenPath << "\n";
+                ++failures;
+            } else {
+                const QFileInfo info(goldenPath);
+                const QString diffPath = info.path() + "/" + info.completeBaseName() + "-diff.png";
+                comparison.diff.save(diffPath);
+                out << "Golden: MISMATCH, " << comparison.differingPixels << " of " << comparison.pixels
+                    << " pixels differ by more than " << tolerance << " (max " << comparison.maxDelta
+                    << "), see " << diffPath << "\n";
+                ++failures;
+            }
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+class FrameStreamWriter;
+class GameScene;
+
+// Renders a GameScene into images with no window, as fast as the scene can
+// be painted rather than at the display's rate. Frames are painted into
+// buffers that are reused from frame to frame; with a stream attached they
+// come from the writer's pool and go to its thread once painted.
+class OffscreenRenderer
+{
+public:
+    // Renders what the scene's camera sees; a null size renders it at 1:1
+    explicit OffscreenRenderer(GameScene *renderScene, const QSize &outputSize = QSize());
+    ~OffscreenRenderer();
+
+    QSize frameSize() const { return size; }
+
+    // Every frame rendered from now on is also written as raw video
+    bool startStream(const QString &path, QString *error = nullptr);
+    bool stopStream(QString *error = nullptr);
+
+    // Paints the scene as it is now. The image stays valid until the next
+    // call; copy it to keep it.
+    const QImage &render();
+
+private:
+    GameScene *scene{nullptr};
+    QSize size;
+    QImage frame;
+    std::unique_ptr<FrameStreamWriter> stream;
+    bool pending{false};  // frame is painted but not yet submitted to the stream
+};
+
+// Per pixel comparison against a reference image. Channels within tolerance
+// count as equal, so antialiasing differences between Qt versions and
+// platforms don't fail a run.
+struct ImageComparison
+{
+    bool sameSize{false};
+    qint64 pixels{0};
+    qint64 differingPixels{0};
+    int maxDelta{0};   // largest channel difference seen
+    QImage diff;       // differing pixels in red over a dimmed copy of the image
+
+    bool matches(double allowedFraction = 0) const
+    {
+        return sameSize && differingPixels <= qint64(allowedFraction * pixels);
+    }
+};
+ImageComparison compareImages(const QImage &actual, const QImage &expected, int tolerance);
+
+// --render: plays a level or a journal offscreen, writing a thumbnail, a raw
+// video stream and/or checking the last frame against a golden image
+int runRender(const QStringList &arguments);
+
+#endif // OFFSCREENRENDERER_H
@@ -0,0 +1,80 @@
+#include "particleitem.h"
+#include "levelpalette.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+
+ParticleItem::ParticleItem(const ParticlePool *particles) : pool(particles)
+{
+    // Only the exposed part is sorted and drawn
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    const LevelPalette &palette = LevelPalette::instance();
+    const QColor base[int(ParticleKind::Count)] = {palette.dust, palette.spark, palette.glow, palette.star};
+    for (int k = 0; k < int(ParticleKind::Count); ++k) {
+        for (int s = 0; s < ParticlePool::Shades; ++s) {
+            QColor color = base[k];
+            color.setAlphaF(base[k].alphaF() * s / (ParticlePool::Shades - 1));
+            colors[size_t(k * ParticlePool::Shades + s)] = color;
+        }
+    }
+    buckets.assign(size_t(pool->capacity()), std::uint8_t(Buckets));
+    rects.resize(size_t(pool->capacity()));
+}
+
+void ParticleItem::setBounds(const QRectF &rect)
+{
+    prepareGeometryChange();
+    bounds = rect;
+}
+
+void ParticleItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    const QRectF exposed = option->exposedRect.intersected(bounds);
+    const int count = pool->size();
+    if (exposed.isEmpty() || count == 0)
+        return;
+    static_assert(Buckets < 256, "bucket indices are bytes");
+
+    // Counting sort by bucket: count, turn counts into starts, place
+    const float left = float(exposed.left());
+    const float top = float(exposed.top());
+    const float right = float(exposed.right());
+    const float bottom = float(exposed.bottom());
+    starts.fill(0);
+    for (int i = 0; i < count; ++i) {
+        const size_t p = size_t(i);
+        const float size = pool->extent[p];
+        const bool visible = pool->shade[p] != 0 && pool->x[p] < right && pool->x[p] + size > left
+                             && pool->y[p] < bottom && pool->y[p] + size > top;
+        const int bucket = visible ? int(pool->kind[p]) * ParticlePool::Shades + pool->shade[p] : Buckets;
+        buckets[p] = std::uint8_t(bucket);
+        ++starts[size_t(bucket)];
+    }
+    int next = 0;
+    for (int &start : starts) {
+        const int size = start;
+        start = next;
+        next += size;
+    }
+    std::array<int, Buckets + 1> ends = starts;
+    for (int i = 0; i < count; ++i) {
+        const size_t p = size_t(i);
+        if (buckets[p] == Buckets)
+            continue;
+        rects[size_t(ends[buckets[p]]++)] = QRectF(pool->x[p], pool->y[p], pool->extent[p], pool->extent[p]);
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(Qt::NoPen);
+    for (int bucket = 0; bucket < Buckets; ++bucket) {
+        const int first = starts[size_t(bucket)];
+        const int size = ends[size_t(bucket)] - first;
+        if (size == 0)
+            continue;
+        painter->setBrush(colors[size_t(bucket)]);
+        painter->drawRects(rects.data() + first, size);
+    }
+    painter->restore();
+}
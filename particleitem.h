@@ -0,0 +1,37 @@
+#ifndef PARTICLEITEM_H
+#define PARTICLEITEM_H
+
+#include <QColor>
+#include <QGraphicsItem>
+#include <QRectF>
+#include <array>
+#include <vector>
+#include "particlepool.h"
+
+// Every particle of a pool in one item. paint() sorts the visible ones by
+// kind and shade into one rect array, then fills each run of it with a
+// single drawRects() call, so the cost is a few brush changes however many
+// particles there are. The rect array is sized to the pool once.
+class ParticleItem : public QGraphicsItem
+{
+public:
+    explicit ParticleItem(const ParticlePool *particles);
+
+    // Particles can be anywhere in here, normally the level
+    void setBounds(const QRectF &rect);
+
+    QRectF boundingRect() const override { return bounds; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    static constexpr int Buckets = int(ParticleKind::Count) * ParticlePool::Shades;
+
+    const ParticlePool *pool{nullptr};
+    QRectF bounds;
+    std::array<QColor, Buckets> colors;
+    std::array<int, Buckets + 1> starts{};
+    std::vector<std::uint8_t> buckets;  // per particle; Buckets when culled
+    std::vector<QRectF> rects;
+};
+
+#endif // PARTICLEITEM_H
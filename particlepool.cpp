@@ -0,0 +1,163 @@
+#include "particlepool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+void unite(WorldRect &bounds, bool &valid, const WorldRect &rect)
+{
+    if (!valid) {
+        bounds = rect;
+        valid = true;
+        return;
+    }
+    const float right = std::max(bounds.right(), rect.right());
+    const float bottom = std::max(bounds.bottom(), rect.bottom());
+    bounds.left = std::min(bounds.left, rect.left);
+    bounds.top = std::min(bounds.top, rect.top);
+    bounds.width = right - bounds.left;
+    bounds.height = bottom - bounds.top;
+}
+
+} // namespace
+
+ParticlePool::ParticlePool(int capacity)
+{
+    const size_t n = size_t(std::max(1, capacity));
+    for (std::vector<float> *array : {&x, &y, &velocityX, &velocityY, &gravity, &age, &life, &extent, &phase, &rate})
+        array->assign(n, 0.0f);
+    kind.assign(n, ParticleKind::Dust);
+    shade.assign(n, 0);
+    changed.reserve(n);
+}
+
+int ParticlePool::add()
+{
+    if (count == capacity())
+        return -1;
+    const int i = count++;
+    velocityX[size_t(i)] = 0;
+    velocityY[size_t(i)] = 0;
+    gravity[size_t(i)] = 0;
+    age[size_t(i)] = 0;
+    rate[size_t(i)] = 0;
+    phase[size_t(i)] = 0;
+    return i;
+}
+
+int ParticlePool::spawn(const Burst &burst, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int spawned = 0;
+    for (; spawned < burst.count; ++spawned) {
+        const int i = add();
+        if (i < 0)
+            break;
+        const size_t p = size_t(i);
+        const float direction = burst.angle + (unit(rng) - 0.5f) * burst.spread;
+        const float speed = burst.minSpeed + (burst.maxSpeed - burst.minSpeed) * unit(rng);
+        x[p] = burst.x - burst.size / 2;
+        y[p] = burst.y - burst.size / 2;
+        velocityX[p] = std::cos(direction) * speed;
+        velocityY[p] = std::sin(direction) * speed;
+        gravity[p] = burst.gravity;
+        life[p] = burst.minLife + (burst.maxLife - burst.minLife) * unit(rng);
+        extent[p] = burst.size;
+        kind[p] = burst.kind;
+        shade[p] = shadeOf(i);
+        unite(moving, movingValid, {x[p], y[p], extent[p], extent[p]});
+    }
+    return spawned;
+}
+
+bool ParticlePool::addStar(float starX, float starY, float size, float startPhase, float swing)
+{
+    const int i = add();
+    if (i < 0)
+        return false;
+    const size_t p = size_t(i);
+    x[p] = starX;
+    y[p] = starY;
+    life[p] = std::numeric_limits<float>::infinity();
+    extent[p] = size;
+    phase[p] = startPhase;
+    rate[p] = swing;
+    kind[p] = ParticleKind::Star;
+    shade[p] = shadeOf(i);
+    return true;
+}
+
+void ParticlePool::clear()
+{
+    count = 0;
+    movingValid = false;
+    dirtyValid = false;
+    changed.clear();
+}
+
+std::uint8_t ParticlePool::shadeOf(int i) const
+{
+    const size_t p = size_t(i);
+    // Fades out over its life; infinite lives don't fade
+    float brightness = 1.0f - age[p] / life[p];
+    if (rate[p] != 0)
+        brightness *= 0.6f + 0.4f * std::sin(phase[p] + age[p] * rate[p]);
+    return std::uint8_t(std::clamp(brightness, 0.0f, 1.0f) * (Shades - 1) + 0.5f);
+}
+
+void ParticlePool::moveParticle(int from, int to)
+{
+    const size_t f = size_t(from);
+    const size_t t = size_t(to);
+    for (std::vector<float> *array : {&x, &y, &velocityX, &velocityY, &gravity, &age, &life, &extent, &phase, &rate})
+        (*array)[t] = (*array)[f];
+    kind[t] = kind[f];
+    shade[t] = shade[f];
+}
+
+void ParticlePool::update(float seconds)
+{
+    changed.clear();
+    // Where moving particles were drawn is dirty as well as where they go
+    dirty = moving;
+    dirtyValid = movingValid;
+    if (count == 0)
+        movingValid = false;
+    if (seconds <= 0 || count == 0)
+        return;
+    movingValid = false;
+
+    // Semi-implicit Euler over plain arrays; no branches, so it vectorizes
+    float *px = x.data();
+    float *py = y.data();
+    float *vx = velocityX.data();
+    float *vy = velocityY.data();
+    const float *g = gravity.data();
+    float *a = age.data();
+    for (int i = 0; i < count; ++i) {
+        vy[i] += g[i] * seconds;
+        px[i] += vx[i] * seconds;
+        py[i] += vy[i] * seconds;
+        a[i] += seconds;
+    }
+
+    for (int i = 0; i < count;) {
+        const size_t p = size_t(i);
+        const WorldRect rect{x[p], y[p], extent[p], extent[p]};
+        if (age[p] >= life[p]) {
+            moveParticle(count - 1, i);
+            --count;
+            continue;
+        }
+        const std::uint8_t next = shadeOf(i);
+        if (velocityX[p] != 0 || velocityY[p] != 0)
+            unite(moving, movingValid, rect);
+        else if (next != shade[p])
+            changed.push_back(rect);
+        shade[p] = next;
+        ++i;
+    }
+    if (movingValid)
+        unite(dirty, dirtyValid, moving);
+}
@@ -0,0 +1,93 @@
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "worldrect.h"
+
+// Looks of a particle; painters keep a color per kind
+enum class ParticleKind : std::uint8_t
+{
+    Dust,   // kicked up on landing
+    Spark,  // the player coming apart on spikes
+    Glow,   // the player coming back at the spawn point
+    Star,   // twinkles in the sky for as long as the level lasts
+    Count
+};
+
+// Fixed-capacity pool of dots as structure-of-arrays. Every array is sized
+// once in the constructor; spawning past the capacity drops particles
+// instead of growing. update() moves and ages everything in one branch-free
+// loop over the arrays, then retires the dead by swapping the last live
+// particle into their place, so live particles are always [0, size()).
+// Purely visual: nothing here feeds back into the world. Units are scene
+// pixels and seconds.
+class ParticlePool
+{
+public:
+    explicit ParticlePool(int capacity);
+
+    // Brightness steps particles are drawn with; 0 is invisible
+    static constexpr int Shades = 16;
+
+    struct Burst
+    {
+        ParticleKind kind{ParticleKind::Dust};
+        float x{0};
+        float y{0};
+        int count{0};
+        float angle{0};          // radians, 0 is right and y points down
+        float spread{6.2831853f};
+        float minSpeed{0};       // px/s
+        float maxSpeed{0};
+        float gravity{0};        // px/s^2
+        float minLife{0.5f};     // s
+        float maxLife{0.5f};
+        float size{2};
+    };
+    // Returns how many particles of the burst fit
+    int spawn(const Burst &burst, std::mt19937 &rng);
+    // Still particle that lives until cleared, its brightness swinging
+    // rate radians per second from phase
+    bool addStar(float x, float y, float size, float phase, float rate);
+    void clear();
+
+    void update(float seconds);
+
+    int size() const { return count; }
+    int capacity() const { return int(x.size()); }
+
+    // Area moving particles covered before and after the last update, and
+    // the still ones whose shade changed in it: what needs repainting
+    bool hasMovingBounds() const { return dirtyValid; }
+    const WorldRect &movingBounds() const { return dirty; }
+    const std::vector<WorldRect> &changedStill() const { return changed; }
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> gravity;
+    std::vector<float> age;
+    std::vector<float> life;
+    std::vector<float> extent;  // side of the square drawn
+    std::vector<float> phase;
+    std::vector<float> rate;
+    std::vector<ParticleKind> kind;
+    std::vector<std::uint8_t> shade;
+
+private:
+    int add();
+    std::uint8_t shadeOf(int i) const;
+    void moveParticle(int from, int to);
+
+    int count{0};
+    WorldRect moving;  // moving particles where they are now
+    bool movingValid{false};
+    WorldRect dirty;
+    bool dirtyValid{false};
+    std::vector<WorldRect> changed;
+};
+
+#endif // PARTICLEPOOL_H
@@ -0,0 +1,28 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <QGraphicsItemGroup>
+#include "spriteitem.h"
+#include "world.h"
+
+// View of the player entity. All of the player's behaviour lives in the
+// world's step; this group only holds the sprite and follows what the
+// simulation did, so it has no timer, no physics and no collision queries.
+class Player : public QGraphicsItemGroup
+{
+public:
+    Player(std::shared_ptr<const SpriteAtlas> atlas, const QSizeF &size);
+
+    // Picks the animation for the entity's state and advances it to now, on
+    // the simulation clock. Returns true if what's drawn changed without
+    // the item moving.
+    bool sync(const PlayerState &state, const PlayerInput &input, double now);
+
+private:
+    SpriteItem *sprite{nullptr};
+    int standAnimation{-1};
+    int runAnimation{-1};
+    int jumpAnimation{-1};
+};
+
+#endif // PLAYER_H
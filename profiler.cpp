@@ -0,0 +1,185 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+std::uint32_t currentThread()
+{
+    // Small stable numbers read better in trace viewers than native ids
+    static std::atomic<std::uint32_t> nextThread{1};
+    thread_local const std::uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return thread;
+}
+
+double toMs(std::uint64_t ns)
+{
+    return ns / 1e6;
+}
+
+} // namespace
+
+Profiler &Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+std::uint64_t Profiler::nowNs()
+{
+    using Clock = std::chrono::steady_clock;
+    static const Clock::time_point origin = Clock::now();
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count());
+}
+
+void Profiler::record(const char *name, std::uint64_t startNs, std::uint64_t durationNs)
+{
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    push(event);
+}
+
+void Profiler::count(const char *name, std::int64_t value)
+{
+    if (!isEnabled())
+        return;
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = nowNs();
+    event.value = value;
+    event.counter = true;
+    push(event);
+}
+
+void Profiler::push(const ProfileEvent &event)
+{
+    const std::uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[index & (Capacity - 1)];
+
+    // Mark the slot busy, fill it, then publish it under its new index
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(event.name, std::memory_order_relaxed);
+    slot.startNs.store(event.startNs, std::memory_order_relaxed);
+    slot.durationNs.store(event.durationNs, std::memory_order_relaxed);
+    slot.value.store(event.value, std::memory_order_relaxed);
+    slot.thread.store(currentThread(), std::memory_order_relaxed);
+    slot.counter.store(event.counter, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::vector<ProfileEvent> Profiler::snapshot() const
+{
+    const std::uint64_t end = head.load(std::memory_order_acquire);
+    const std::uint64_t begin = end > Capacity ? end - Capacity : 0;
+
+    std::vector<ProfileEvent> events;
+    events.reserve(std::size_t(end - begin));
+    for (std::uint64_t index = begin; index < end; ++index) {
+        const Slot &slot = slots[index & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+            continue;
+        ProfileEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        event.value = slot.value.load(std::memory_order_relaxed);
+        event.thread = slot.thread.load(std::memory_order_relaxed);
+        event.counter = slot.counter.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == index + 1)
+            events.push_back(event);
+    }
+    return events;
+}
+
+Profiler::Summary Profiler::summarize(double windowSeconds) const
+{
+    const std::vector<ProfileEvent> events = snapshot();
+    const std::uint64_t now = nowNs();
+    const std::uint64_t window = std::uint64_t(windowSeconds * 1e9);
+    const std::uint64_t since = now > window ? now - window : 0;
+
+    Summary summary;
+    std::vector<std::uint64_t> frames;
+    std::vector<double> stageTotals;
+    std::int64_t scannedTotal = 0;
+    int scannedPasses = 0;
+
+    for (const ProfileEvent &event : events) {
+        if (event.startNs < since || !event.name)
+            continue;
+        if (event.counter) {
+            if (std::strcmp(event.name, ScannedCounter) == 0) {
+                scannedTotal += event.value;
+                summary.scannedMax = std::max(summary.scannedMax, event.value);
+                ++scannedPasses;
+            }
+            continue;
+        }
+        if (std::strcmp(event.name, FrameEvent) == 0) {
+            frames.push_back(event.durationNs);
+            continue;
+        }
+
+        auto stage = std::find_if(summary.stages.begin(), summary.stages.end(),
+                                  [&](const StageTime &s) { return std::strcmp(s.name, event.name) == 0; });
+        if (stage == summary.stages.end()) {
+            summary.stages.push_back(StageTime{event.name, 0, 0});
+            stageTotals.push_back(0);
+            stage = summary.stages.end() - 1;
+        }
+        stageTotals[std::size_t(stage - summary.stages.begin())] += toMs(event.durationNs);
+        stage->maxMs = std::max(stage->maxMs, toMs(event.durationNs));
+    }
+
+    summary.frames = int(frames.size());
+    const double perFrame = summary.frames ? 1.0 / summary.frames : 0.0;
+    for (std::size_t i = 0; i < summary.stages.size(); ++i)
+        summary.stages[i].averageMs = stageTotals[i] * perFrame;
+    if (scannedPasses)
+        summary.scannedAverage = double(scannedTotal) / scannedPasses;
+
+    if (!frames.empty()) {
+        std::sort(frames.begin(), frames.end());
+        auto percentile = [&](double p) {
+            const std::size_t index = std::min(frames.size() - 1, std::size_t(p * frames.size()));
+            return toMs(frames[index]);
+        };
+        summary.frameP50Ms = percentile(0.50);
+        summary.frameP99Ms = percentile(0.99);
+    }
+    return summary;
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) const
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    // Timestamps are in microseconds; names are literals from our own code,
+    // so they need no JSON escaping
+    std::fputs("{\"traceEvents\":[", file);
+    bool first = true;
+    for (const ProfileEvent &event : snapshot()) {
+        if (!event.name)
+            continue;
+        std::fputs(first ? "\n" : ",\n", file);
+        first = false;
+        if (event.counter) {
+            std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+                               "\"args\":{\"value\":%lld}}",
+                         event.name, event.startNs / 1e3, event.thread, (long long)event.value);
+        } else {
+            std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                         event.name, event.startNs / 1e3, event.durationNs / 1e3, event.thread);
+        }
+    }
+    std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,121 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped timers and counters recorded into a fixed ring buffer. Recording is
+// lock-free and allocation-free, so it can stay on in release builds and on
+// any thread; the oldest events are overwritten once the ring is full. No Qt
+// here, so the headless world can be instrumented too.
+//
+// Event names must be string literals (or otherwise outlive the profiler).
+
+struct ProfileEvent
+{
+    const char *name{nullptr};
+    std::uint64_t startNs{0};
+    std::uint64_t durationNs{0};  // zero for counters
+    std::int64_t value{0};        // counter value
+    std::uint32_t thread{0};
+    bool counter{false};
+};
+
+class Profiler
+{
+public:
+    static constexpr std::size_t Capacity = 1 << 14;  // power of two
+
+    // Names the overlay and the summary know about
+    static constexpr const char *FrameEvent = "frame";
+    static constexpr const char *ScannedCounter = "collidersScanned";
+    static constexpr const char *InputLatencyCounter = "inputLatencyUs";
+
+    static Profiler &instance();
+    // Monotonic nanoseconds since the profiler was first used
+    static std::uint64_t nowNs();
+
+    void setEnabled(bool enabled) { active.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return active.load(std::memory_order_relaxed); }
+
+    void record(const char *name, std::uint64_t startNs, std::uint64_t durationNs);
+    void count(const char *name, std::int64_t value);
+
+    // Events still in the ring, oldest first. Slots being overwritten while
+    // this runs are left out rather than returned torn.
+    std::vector<ProfileEvent> snapshot() const;
+
+    struct StageTime
+    {
+        const char *name{nullptr};
+        double averageMs{0};  // per frame
+        double maxMs{0};      // longest single call
+    };
+
+    struct Summary
+    {
+        int frames{0};
+        double frameP50Ms{0};
+        double frameP99Ms{0};
+        std::vector<StageTime> stages;  // in order of first appearance
+        double scannedAverage{0};       // colliders per collision pass
+        std::int64_t scannedMax{0};
+    };
+
+    // Aggregates the events of the last windowSeconds
+    Summary summarize(double windowSeconds) const;
+
+    // Chrome trace event format, loadable in chrome://tracing or Perfetto
+    bool writeChromeTrace(const std::string &path) const;
+
+private:
+    Profiler() = default;
+
+    // Each field is atomic so a reader racing a writer sees old or new
+    // values, never undefined ones; the sequence says which
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence{0};  // index + 1 once written
+        std::atomic<const char *> name{nullptr};
+        std::atomic<std::uint64_t> startNs{0};
+        std::atomic<std::uint64_t> durationNs{0};
+        std::atomic<std::int64_t> value{0};
+        std::atomic<std::uint32_t> thread{0};
+        std::atomic<bool> counter{false};
+    };
+
+    void push(const ProfileEvent &event);
+
+    std::array<Slot, Capacity> slots;
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<bool> active{true};
+};
+
+// Records the time between construction and destruction
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name)
+        : name(name), enabled(Profiler::instance().isEnabled()), start(enabled ? Profiler::nowNs() : 0)
+    {
+    }
+    ~ProfileScope()
+    {
+        if (enabled)
+            Profiler::instance().record(name, start, Profiler::nowNs() - start);
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    const char *name;
+    bool enabled;
+    std::uint64_t start;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,34 @@
+#ifndef RANDOMWALKBOT_H
+#define RANDOMWALKBOT_H
+
+#include <cstdint>
+#include <random>
+#include "world.h"
+
+// Holds a direction for a random while, mostly towards the exit, and jumps
+// now and then. Dumb, but thousands of them cover a level quickly.
+class RandomWalkBot
+{
+public:
+    explicit RandomWalkBot(std::uint32_t seed) : rng(seed) {}
+
+    PlayerInput next()
+    {
+        if (holdTicks == 0) {
+            const std::uint32_t roll = rng() % 10;
+            input.moveRight = roll < 6;
+            input.moveLeft = roll >= 6 && roll < 8;
+            holdTicks = 10 + int(rng() % 50);
+        }
+        --holdTicks;
+        input.jump = rng() % 15 == 0;
+        return input;
+    }
+
+private:
+    std::mt19937 rng;
+    PlayerInput input;
+    int holdTicks{0};
+};
+
+#endif // RANDOMWALKBOT_H
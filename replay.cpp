@@ -0,0 +1,109 @@
+#include "replay.h"
+#include "levelfile.h"
+#include "profiler.h"
+#include "world.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <map>
+#include <memory>
+
+ReplayResult replayJournal(const InputJournal &journal,
+                           const std::function<const LevelView *(int level)> &levelFor)
+{
+    ReplayResult result;
+    const std::vector<InputJournal::Segment> &segments = journal.segments();
+    if (segments.empty()) {
+        result.error = "journal has no segments";
+        return result;
+    }
+
+    for (size_t s = 0; s < segments.size(); ++s) {
+        const InputJournal::Segment &segment = segments[s];
+        const LevelView *level = levelFor(segment.level);
+        if (!level) {
+            result.error = "cannot load level " + std::to_string(segment.level);
+            return result;
+        }
+
+        // Built exactly like LevelStreamer::prepare builds the live world
+        World world;
+        world.setTickRate(segment.ticksPerSecond);
+        world.loadLevel(*level);
+        for (const InputJournal::InputRun &run : segment.runs) {
+            const PlayerInput input = InputJournal::unpack(run.bits);
+            for (std::uint32_t i = 0; i < run.length; ++i) {
+                world.setInput(input.moveLeft, input.moveRight);
+                world.setRewinding(input.rewind);
+                if (input.jump)
+                    world.requestJump(input.jumpPhase);
+                world.step();
+            }
+        }
+        result.ticks += segment.ticks;
+
+        result.finalHash = world.stateHash();
+        result.expectedHash = segment.endHash;
+        if (result.finalHash != segment.endHash && result.divergedSegment < 0)
+            result.divergedSegment = int(s);
+    }
+
+    result.matched = result.divergedSegment < 0;
+    return result;
+}
+
+int runReplay(const QStringList &paths)
+{
+    QTextStream out(stdout);
+    if (paths.isEmpty()) {
+        out << "usage: --replay <journal>...\n";
+        return 2;
+    }
+    // Nobody reads the profile, and recording it would be timed too
+    Profiler::instance().setEnabled(false);
+
+    // Levels are mapped once and shared by every session
+    std::map<int, std::unique_ptr<LevelFile>> levels;
+    auto levelFor = [&levels](int number) -> const LevelView * {
+        auto found = levels.find(number);
+        if (found == levels.end()) {
+            std::unique_ptr<LevelFile> file(new LevelFile);
+            if (!file->open(number))
+                return nullptr;
+            found = levels.emplace(number, std::move(file)).first;
+        }
+        return &found->second->view();
+    };
+
+    int failures = 0;
+    std::uint64_t ticks = 0;
+    QElapsedTimer clock;
+    clock.start();
+    for (const QString &path : paths) {
+        InputJournal journal;
+        std::string error;
+        if (!journal.load(path.toStdString(), &error)) {
+            out << path << ": " << QString::fromStdString(error) << "\n";
+            ++failures;
+            continue;
+        }
+
+        const ReplayResult result = replayJournal(journal, levelFor);
+        ticks += result.ticks;
+        if (!result.error.empty()) {
+            out << path << ": " << QString::fromStdString(result.error) << "\n";
+            ++failures;
+        } else if (!result.matched) {
+            out << path << ": diverged in segment " << result.divergedSegment << " of "
+                << journal.segments().size() << "\n";
+            ++failures;
+        } else {
+            out << path << ": ok, " << result.ticks << " ticks, state "
+                << QString::number(result.finalHash, 16) << "\n";
+        }
+    }
+
+    const double seconds = clock.nsecsElapsed() / 1e9;
+    out << "Replayed " << paths.size() << " sessions, " << ticks << " ticks in "
+        << QString::number(seconds, 'f', 3) << " s, " << failures << " failed\n";
+    return failures ? 1 : 0;
+}
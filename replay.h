@@ -0,0 +1,32 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <QStringList>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "inputjournal.h"
+
+class LevelView;
+
+struct ReplayResult
+{
+    bool matched{false};
+    std::string error;            // set when the replay couldn't run at all
+    std::uint64_t ticks{0};
+    int divergedSegment{-1};      // first segment whose end hash differs
+    std::uint64_t finalHash{0};
+    std::uint64_t expectedHash{0};
+};
+
+// Re-simulates every segment of a journal as fast as possible, feeding each
+// tick the input recorded for it. levelFor returns the level a segment was
+// played on, or nullptr if it can't be loaded; the views are only read.
+ReplayResult replayJournal(const InputJournal &journal,
+                           const std::function<const LevelView *(int level)> &levelFor);
+
+// Command line entry point for --replay <journal>...; exits non-zero if any
+// session fails to reproduce
+int runReplay(const QStringList &paths);
+
+#endif // REPLAY_H
@@ -0,0 +1,206 @@
+#include "rewindbuffer.h"
+#include "deltacodec.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <random>
+
+namespace {
+
+// Size of a run token in a delta, see DeltaCodec
+constexpr std::size_t TokenBytes = 4;
+
+} // namespace
+
+void RewindBuffer::reset(std::size_t stateSize, int capacityTicks, int keyframeInterval)
+{
+    blockSize = stateSize;
+    interval = std::max(1, keyframeInterval);
+    const int ticks = std::max(1, capacityTicks);
+    entries.assign(size_t(ticks), Entry());
+
+    // A keyframe per interval and deltas about half a block; busier
+    // worlds just hold fewer ticks. Always room for a couple of keyframes.
+    const std::size_t keyframes = size_t(ticks / interval + 2);
+    data.assign(std::max(keyframes * blockSize + size_t(ticks) * (blockSize / 2 + 2 * TokenBytes),
+                         2 * DeltaCodec::maxEncodedSize(blockSize)),
+                0);
+    last.assign(blockSize, 0);
+    scratch.assign(DeltaCodec::maxEncodedSize(blockSize), 0);
+    clear();
+}
+
+void RewindBuffer::clear()
+{
+    first = 0;
+    count = 0;
+    sinceKeyframe = 0;
+}
+
+std::size_t RewindBuffer::bytesUsed() const
+{
+    std::size_t bytes = 0;
+    for (int i = 0; i < count; ++i)
+        bytes += entry(i).bytes;
+    return bytes;
+}
+
+void RewindBuffer::push(const void *state)
+{
+    if (blockSize == 0)
+        return;
+    const std::uint8_t *block = static_cast<const std::uint8_t *>(state);
+
+    // XOR into the scratch block, then run-length encode it in place behind itself
+    bool keyframe = count == 0 || sinceKeyframe + 1 >= interval;
+    std::size_t bytes = blockSize;
+    if (!keyframe) {
+        std::uint8_t *delta = scratch.data() + (scratch.size() - blockSize);
+        for (std::size_t i = 0; i < blockSize; ++i)
+            delta[i] = block[i] ^ last[i];
+        bytes = DeltaCodec::encode(delta, blockSize, scratch.data());
+        // Nothing to gain over the block itself
+        if (bytes >= blockSize) {
+            keyframe = true;
+            bytes = blockSize;
+        }
+    }
+
+    if (count == int(entries.size()))
+        dropOldest();
+    std::size_t offset = reserve(bytes);
+    // Making room can drop everything, and a delta can't be the oldest entry
+    if (count == 0 && !keyframe) {
+        keyframe = true;
+        bytes = blockSize;
+        offset = reserve(bytes);
+    }
+    std::memcpy(data.data() + offset, keyframe ? block : scratch.data(), bytes);
+    std::memcpy(last.data(), block, blockSize);
+
+    Entry &added = entries[size_t((first + count) % int(entries.size()))];
+    added.offset = offset;
+    added.bytes = bytes;
+    added.keyframe = keyframe;
+    ++count;
+    sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+}
+
+bool RewindBuffer::peek(int ticksBack, void *out) const
+{
+    const int index = count - 1 - ticksBack;
+    if (ticksBack < 0 || index < 0)
+        return false;
+
+    // The oldest entry is always a keyframe; if it isn't, fail rather than run off the front
+    int key = index;
+    while (key >= 0 && !entry(key).keyframe)
+        --key;
+    if (key < 0)
+        return false;
+    std::uint8_t *state = static_cast<std::uint8_t *>(out);
+    std::memcpy(state, data.data() + entry(key).offset, blockSize);
+    for (int i = key + 1; i <= index; ++i)
+        DeltaCodec::apply(data.data() + entry(i).offset, entry(i).bytes, state, blockSize);
+    return true;
+}
+
+bool RewindBuffer::rewind(int ticksBack, void *out)
+{
+    if (!peek(ticksBack, out))
+        return false;
+    count -= ticksBack;
+    int key = count - 1;
+    while (!entry(key).keyframe)
+        --key;
+    sinceKeyframe = count - 1 - key;
+    std::memcpy(last.data(), out, blockSize);
+    return true;
+}
+
+std::size_t RewindBuffer::reserve(std::size_t bytes)
+{
+    // Entries sit back to back; one that doesn't fit before the end of the
+    // buffer starts over at the front. Either way, it may not reach the oldest.
+    for (;;) {
+        if (count == 0)
+            return 0;
+        const Entry &oldest = entry(0);
+        const Entry &newest = entry(count - 1);
+        const std::size_t head = newest.offset + newest.bytes;
+        if (oldest.offset <= newest.offset) {
+            if (head + bytes <= data.size())
+                return head;
+            if (bytes <= oldest.offset)
+                return 0;
+        } else if (head + bytes <= oldest.offset) {
+            return head;
+        }
+        dropOldest();
+    }
+}
+
+void RewindBuffer::dropOldest()
+{
+    // Deltas after the oldest keyframe are useless without it
+    do {
+        first = (first + 1) % int(entries.size());
+        --count;
+    } while (count > 0 && !entry(0).keyframe);
+    if (count == 0)
+        sinceKeyframe = 0;
+}
+
+bool RewindBuffer::verify(int rounds, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    struct Shape
+    {
+        std::size_t stateSize;
+        int capacityTicks;
+        int keyframeInterval;
+    };
+    // Few ticks and big blocks, so busy deltas run the data out often
+    const Shape shapes[] = {{64, 1, 30}, {64, 2, 1}, {256, 10, 30}, {256, 10, 4}, {1000, 50, 30}, {97, 50, 7}};
+
+    for (const Shape &shape : shapes) {
+        RewindBuffer buffer;
+        buffer.reset(shape.stateSize, shape.capacityTicks, shape.keyframeInterval);
+        std::deque<std::vector<std::uint8_t>> pushed;  // newest at the back
+        std::vector<std::uint8_t> state(shape.stateSize, 0), out(shape.stateSize);
+
+        auto matches = [&](int ticksBack) {
+            return buffer.peek(ticksBack, out.data()) && out == pushed[pushed.size() - 1 - size_t(ticksBack)];
+        };
+
+        for (int round = 0; round < rounds; ++round) {
+            // Mostly a few bytes, sometimes all of them
+            const std::size_t changes = rng() % 4 == 0 ? shape.stateSize : rng() % 8;
+            for (std::size_t i = 0; i < changes; ++i)
+                state[rng() % shape.stateSize] = std::uint8_t(rng());
+            buffer.push(state.data());
+            pushed.push_back(state);
+
+            const int held = buffer.size();
+            if (held < 1 || held > shape.capacityTicks || held > int(pushed.size()))
+                return false;
+            while (int(pushed.size()) > held)
+                pushed.pop_front();
+            if (!matches(0) || !matches(held - 1) || !matches(int(rng() % unsigned(held))))
+                return false;
+            if (buffer.peek(held, out.data()))
+                return false;
+
+            if (rng() % 16 == 0) {
+                const int back = int(rng() % unsigned(held));
+                if (!buffer.rewind(back, out.data()) || buffer.size() != held - back)
+                    return false;
+                pushed.resize(pushed.size() - size_t(back));
+                if (out != pushed.back())
+                    return false;
+                state = out;
+            }
+        }
+    }
+    return true;
+}
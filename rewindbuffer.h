@@ -0,0 +1,59 @@
+#ifndef REWINDBUFFER_H
+#define REWINDBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ring of fixed-size state blocks, one per tick, for rewinding. Every
+// keyframeInterval-th block is kept whole; the others are stored as the XOR
+// against the block before them, run-length encoded, which for a world that
+// barely changes between ticks is a few dozen bytes. All memory is taken in
+// reset(); when it runs out the oldest keyframe and its deltas go, so the
+// buffer holds fewer ticks rather than allocating.
+class RewindBuffer
+{
+public:
+    void reset(std::size_t stateSize, int capacityTicks, int keyframeInterval = 30);
+    void clear();
+
+    void push(const void *state);
+
+    int size() const { return count; }
+    std::size_t stateSize() const { return blockSize; }
+    std::size_t bytesUsed() const;
+
+    // Rebuilds the block ticksBack ticks before the newest (0 is the newest)
+    // into out. Costs one keyframe copy and at most an interval of deltas.
+    bool peek(int ticksBack, void *out) const;
+    // Like peek(), then forgets everything newer, so pushing continues from there
+    bool rewind(int ticksBack, void *out);
+
+    // Pushes rounds random states, from barely changed to all new, through
+    // small buffers and checks every peek and rewind against copies kept aside
+    static bool verify(int rounds, unsigned seed);
+
+private:
+    struct Entry
+    {
+        std::size_t offset{0};
+        std::size_t bytes{0};
+        bool keyframe{false};
+    };
+
+    const Entry &entry(int index) const { return entries[size_t((first + index) % int(entries.size()))]; }
+    std::size_t reserve(std::size_t bytes);
+    void dropOldest();
+
+    std::size_t blockSize{0};
+    int interval{30};
+    std::vector<std::uint8_t> data;
+    std::vector<Entry> entries;  // ring, oldest at first
+    int first{0};
+    int count{0};
+    int sinceKeyframe{0};
+    std::vector<std::uint8_t> last;     // newest block, what the next delta is against
+    std::vector<std::uint8_t> scratch;  // XOR of the incoming block and last
+};
+
+#endif // REWINDBUFFER_H
@@ -0,0 +1,37 @@
+#include "selftest.h"
+#include "aabbkernel.h"
+#include "rewindbuffer.h"
+#include <QTextStream>
+
+int runSelfTest(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    int rounds = 10000;
+    if (!arguments.isEmpty()) {
+        bool ok = false;
+        rounds = arguments.first().toInt(&ok);
+        if (!ok || rounds <= 0) {
+            out << "usage: --selftest [rounds]\n";
+            return 2;
+        }
+    }
+
+    // ISAs are ordered, and everything up to the best one runs here
+    int failures = 0;
+    const int best = int(AabbKernel::bestSupportedIsa());
+    for (int isa = int(AabbKernel::Isa::Sse2); isa <= best; ++isa) {
+        const bool matched = AabbKernel::verify(AabbKernel::Isa(isa), rounds, 1);
+        out << "aabb kernel " << AabbKernel::isaName(AabbKernel::Isa(isa)) << ": "
+            << (matched ? "ok" : "MISMATCH") << "\n";
+        if (!matched)
+            ++failures;
+    }
+    if (best == int(AabbKernel::Isa::Scalar))
+        out << "aabb kernel: only the scalar path is built for this CPU\n";
+
+    const bool rewound = RewindBuffer::verify(rounds, 1);
+    out << "rewind buffer: " << (rewound ? "ok" : "MISMATCH") << "\n";
+    if (!rewound)
+        ++failures;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <QStringList>
+
+// Command line entry point for --selftest [rounds]. Checks every collision
+// kernel ISA this CPU supports against the scalar reference, and the rewind
+// buffer against plain copies of what went in, and exits non-zero if any of
+// them disagrees, so release builds and CI can run it too.
+int runSelfTest(const QStringList &arguments);
+
+#endif // SELFTEST_H
@@ -0,0 +1,113 @@
+#include "spatialgrid.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::reset(float width, float height, float size)
+{
+    cellSize = size;
+    inverseCellSize = 1.0f / size;
+    cols = std::max(1, int(std::ceil(width * inverseCellSize)));
+    rowCount = std::max(1, int(std::ceil(height * inverseCellSize)));
+
+    cells.assign(size_t(cols) * rowCount, {});
+    ranges.clear();
+    visited.clear();
+    queryStamp = 0;
+}
+
+SpatialGrid::CellRange SpatialGrid::rangeFor(const WorldRect &rect) const
+{
+    auto clampColumn = [this](float v) { return std::clamp(int(std::floor(v * inverseCellSize)), 0, cols - 1); };
+    auto clampRow = [this](float v) { return std::clamp(int(std::floor(v * inverseCellSize)), 0, rowCount - 1); };
+
+    CellRange range;
+    range.x0 = clampColumn(rect.left);
+    range.x1 = clampColumn(rect.right());
+    range.y0 = clampRow(rect.top);
+    range.y1 = clampRow(rect.bottom());
+    return range;
+}
+
+void SpatialGrid::link(int id, const CellRange &range)
+{
+    for (int y = range.y0; y <= range.y1; ++y)
+        for (int x = range.x0; x <= range.x1; ++x)
+            cells[size_t(y) * cols + x].push_back(id);
+}
+
+void SpatialGrid::unlink(int id, const CellRange &range)
+{
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            std::vector<int> &cell = cells[size_t(y) * cols + x];
+            auto it = std::find(cell.begin(), cell.end(), id);
+            if (it != cell.end()) {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+void SpatialGrid::insert(int id, const WorldRect &rect)
+{
+    if (id >= int(ranges.size())) {
+        ranges.resize(id + 1);
+        visited.resize(id + 1, 0);
+    }
+    ranges[id] = rangeFor(rect);
+    link(id, ranges[id]);
+}
+
+void SpatialGrid::move(int id, const WorldRect &rect)
+{
+    const CellRange next = rangeFor(rect);
+    CellRange &current = ranges[id];
+    if (next == current)
+        return;
+
+    // Drop the cells we left, add the ones we entered
+    for (int y = current.y0; y <= current.y1; ++y) {
+        for (int x = current.x0; x <= current.x1; ++x) {
+            if (x < next.x0 || x > next.x1 || y < next.y0 || y > next.y1)
+                unlink(id, {x, y, x, y});
+        }
+    }
+    for (int y = next.y0; y <= next.y1; ++y) {
+        for (int x = next.x0; x <= next.x1; ++x) {
+            if (x < current.x0 || x > current.x1 || y < current.y0 || y > current.y1)
+                link(id, {x, y, x, y});
+        }
+    }
+    current = next;
+}
+
+void SpatialGrid::remove(int id)
+{
+    unlink(id, ranges[id]);
+    ranges[id] = CellRange();
+}
+
+void SpatialGrid::query(const WorldRect &rect, std::vector<int> &out) const
+{
+    if (cells.empty())
+        return;
+
+    if (++queryStamp == 0) {
+        // Stamp wrapped around; start over so stale stamps can't match
+        std::fill(visited.begin(), visited.end(), 0);
+        queryStamp = 1;
+    }
+
+    const CellRange range = rangeFor(rect);
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            for (int id : cells[size_t(y) * cols + x]) {
+                if (visited[id] != queryStamp) {
+                    visited[id] = queryStamp;
+                    out.push_back(id);
+                }
+            }
+        }
+    }
+}
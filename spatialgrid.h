@@ -0,0 +1,55 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+#include "worldrect.h"
+
+// Uniform grid over the level bounds used as the collision broadphase.
+// Objects are identified by caller-chosen dense ids. Anything hanging off the
+// edge of the level is binned into the border cells, so queries outside the
+// bounds still find it.
+class SpatialGrid
+{
+public:
+    static constexpr float DefaultCellSize = 64.0f;
+
+    void reset(float width, float height, float cellSize = DefaultCellSize);
+
+    void insert(int id, const WorldRect &rect);
+    // Only touches the cells the object actually entered or left
+    void move(int id, const WorldRect &rect);
+    void remove(int id);
+
+    // Appends every id whose cells overlap rect, each at most once
+    void query(const WorldRect &rect, std::vector<int> &out) const;
+
+    int columns() const { return cols; }
+    int rows() const { return rowCount; }
+
+private:
+    struct CellRange
+    {
+        int x0{0}, y0{0}, x1{-1}, y1{-1};
+        bool operator==(const CellRange &o) const
+        {
+            return x0 == o.x0 && y0 == o.y0 && x1 == o.x1 && y1 == o.y1;
+        }
+    };
+
+    CellRange rangeFor(const WorldRect &rect) const;
+    void link(int id, const CellRange &range);
+    void unlink(int id, const CellRange &range);
+
+    float cellSize{DefaultCellSize};
+    float inverseCellSize{1.0f / DefaultCellSize};
+    int cols{0};
+    int rowCount{0};
+    std::vector<std::vector<int>> cells;
+    std::vector<CellRange> ranges;
+
+    // Per-object stamp so an object spanning several cells is reported once
+    mutable std::vector<unsigned> visited;
+    mutable unsigned queryStamp{0};
+};
+
+#endif // SPATIALGRID_H
@@ -0,0 +1,162 @@
+#include "spriteatlas.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+std::shared_ptr<const SpriteAtlas> SpriteAtlas::shared(const QString &metadataPath)
+{
+    // Weak, so the pixmaps go away with the last sprite rather than after
+    // the application object
+    static QHash<QString, std::weak_ptr<const SpriteAtlas>> atlases;
+    std::shared_ptr<const SpriteAtlas> atlas = atlases.value(metadataPath).lock();
+    if (!atlas) {
+        QString error;
+        atlas = load(metadataPath, &error);
+        if (!atlas) {
+            qWarning() << "Cannot load sprite atlas" << metadataPath << ":" << error;
+            atlas = std::make_shared<SpriteAtlas>();
+        }
+        atlases.insert(metadataPath, atlas);
+    }
+    return atlas;
+}
+
+std::shared_ptr<SpriteAtlas> SpriteAtlas::load(const QString &metadataPath, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return std::shared_ptr<SpriteAtlas>();
+    };
+
+    QFile file(metadataPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(file.errorString());
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull())
+        return fail(parseError.errorString());
+    const QJsonObject root = document.object();
+
+    auto atlas = std::make_shared<SpriteAtlas>();
+    QHash<QString, int> frameIds;
+    std::vector<QString> frameNames;
+    for (const QJsonValue &value : root.value("frames").toArray()) {
+        const QJsonObject frame = value.toObject();
+        const QJsonArray rect = frame.value("rect").toArray();
+        if (rect.size() != 4)
+            return fail(QString("frame %1 needs a rect").arg(frameNames.size()));
+        frameIds.insert(frame.value("name").toString(), int(atlas->frames.size()));
+        frameNames.push_back(frame.value("name").toString());
+        atlas->frames.emplace_back(rect[0].toDouble(), rect[1].toDouble(), rect[2].toDouble(), rect[3].toDouble());
+    }
+
+    const QJsonObject animations = root.value("animations").toObject();
+    for (auto it = animations.begin(); it != animations.end(); ++it) {
+        const QJsonObject entry = it.value().toObject();
+        Animation animation;
+        animation.firstStep = int(atlas->steps.size());
+        animation.fps = float(entry.value("fps").toDouble(10));
+        animation.loop = entry.value("loop").toBool(true);
+        for (const QJsonValue &name : entry.value("frames").toArray()) {
+            const auto frame = frameIds.constFind(name.toString());
+            if (frame == frameIds.constEnd())
+                return fail(QString("animation %1 uses unknown frame %2").arg(it.key(), name.toString()));
+            atlas->steps.push_back(std::uint16_t(frame.value()));
+        }
+        animation.stepCount = int(atlas->steps.size()) - animation.firstStep;
+        if (animation.stepCount == 0 || animation.fps <= 0)
+            return fail(QString("animation %1 has no frames or rate").arg(it.key()));
+        atlas->animations.push_back(animation);
+        atlas->animationNames.push_back(it.key());
+    }
+
+    // The image sits next to the metadata
+    const QString imagePath = QFileInfo(metadataPath).dir().filePath(root.value("image").toString());
+    if (!atlas->image.load(imagePath))
+        atlas->paintFallback(frameNames);
+    return atlas;
+}
+
+int SpriteAtlas::animationId(const QString &name) const
+{
+    for (size_t i = 0; i < animationNames.size(); ++i) {
+        if (animationNames[i] == name)
+            return int(i);
+    }
+    return -1;
+}
+
+int SpriteAtlas::frameAt(int animationId, double seconds) const
+{
+    if (animationId < 0 || animationId >= int(animations.size()))
+        return -1;
+    const Animation &animation = animations[size_t(animationId)];
+    int step = int(std::floor(std::max(0.0, seconds) * animation.fps));
+    step = animation.loop ? step % animation.stepCount : std::min(step, animation.stepCount - 1);
+    return steps[size_t(animation.firstStep + step)];
+}
+
+void SpriteAtlas::paintFallback(const std::vector<QString> &frameNames)
+{
+    // A little figure per frame, posed by the frame's name: "run3" swings
+    // its legs, "jump" tucks them, anything else stands and breathes
+    QRectF bounds;
+    for (const QRectF &frame : frames)
+        bounds |= frame;
+    image = QPixmap(qMax(1, int(std::ceil(bounds.right()))), qMax(1, int(std::ceil(bounds.bottom()))));
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const qreal pi = 3.14159265358979;
+    const QColor body(0, 130, 230);
+    const QColor outline(0, 60, 120);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const QRectF &r = frames[i];
+        const QString &name = frameNames[i];
+        const int phase = name.right(1).toInt();
+        const qreal w = r.width();
+        const qreal h = r.height();
+
+        painter.save();
+        painter.translate(r.topLeft());
+        painter.setClipRect(QRectF(0, 0, w, h));
+        painter.setPen(QPen(outline, w / 16));
+
+        qreal bob = 0;
+        qreal legSwing = 0;
+        bool tucked = false;
+        if (name.startsWith("run")) {
+            legSwing = std::sin(phase * pi / 3) * w * 0.18;
+            bob = std::abs(std::cos(phase * pi / 3)) * h * 0.04;
+        } else if (name.startsWith("jump")) {
+            tucked = true;
+        } else {
+            bob = phase * h * 0.03;
+        }
+
+        // Legs
+        const qreal hipY = h * 0.62 + bob;
+        const qreal footY = tucked ? h * 0.82 : h * 0.97;
+        painter.drawLine(QPointF(w * 0.45, hipY), QPointF(w * 0.45 + legSwing - (tucked ? w * 0.12 : 0), footY));
+        painter.drawLine(QPointF(w * 0.55, hipY), QPointF(w * 0.55 - legSwing + (tucked ? w * 0.12 : 0), footY));
+        // Body and head
+        painter.setBrush(body);
+        painter.drawRoundedRect(QRectF(w * 0.3, h * 0.3 + bob, w * 0.4, h * 0.35), w * 0.08, w * 0.08);
+        painter.drawEllipse(QRectF(w * 0.34, h * 0.04 + bob, w * 0.32, h * 0.28));
+        // Eye, looking the way the sprite faces
+        painter.setBrush(Qt::white);
+        painter.setPen(Qt::NoPen);
+        painter.drawEllipse(QRectF(w * 0.53, h * 0.12 + bob, w * 0.08, h * 0.08));
+        painter.restore();
+    }
+}
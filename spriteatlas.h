@@ -0,0 +1,55 @@
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <QPixmap>
+#include <QRectF>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One packed texture plus the frame table describing it (see anim/kid.json).
+// The metadata is parsed once; playback is then a lookup into two flat
+// arrays, so any number of sprites can share an atlas and animate without
+// decoding images or allocating per frame.
+//
+// QPixmap is GUI-thread only, and so are atlases.
+class SpriteAtlas
+{
+public:
+    struct Animation
+    {
+        int firstStep{0};   // into the step table
+        int stepCount{0};
+        float fps{0};
+        bool loop{true};
+    };
+
+    // Atlas for a metadata file, loaded on first use and shared while in use.
+    // When the image named by the metadata is missing the frames are drawn
+    // procedurally, so the game still has something to animate.
+    static std::shared_ptr<const SpriteAtlas> shared(const QString &metadataPath);
+
+    static std::shared_ptr<SpriteAtlas> load(const QString &metadataPath, QString *error = nullptr);
+
+    const QPixmap &pixmap() const { return image; }
+    int frameCount() const { return int(frames.size()); }
+    const QRectF &frame(int index) const { return frames[size_t(index)]; }
+
+    // -1 for unknown names; resolve once and keep the id
+    int animationId(const QString &name) const;
+    const Animation &animation(int id) const { return animations[size_t(id)]; }
+    // Frame shown after playing an animation for the given time
+    int frameAt(int animationId, double seconds) const;
+
+private:
+    void paintFallback(const std::vector<QString> &frameNames);
+
+    QPixmap image;
+    std::vector<QRectF> frames;
+    std::vector<std::uint16_t> steps;  // frame indices, animations back to back
+    std::vector<Animation> animations;
+    std::vector<QString> animationNames;
+};
+
+#endif // SPRITEATLAS_H
@@ -0,0 +1,57 @@
+#include "spriteitem.h"
+#include <QPainter>
+
+SpriteItem::SpriteItem(std::shared_ptr<const SpriteAtlas> atlas, const QSizeF &size, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+    atlas(std::move(atlas)),
+    size(size)
+{
+}
+
+void SpriteItem::play(int animationId, double now)
+{
+    if (animationId == currentAnimation)
+        return;
+    currentAnimation = animationId;
+    startedAt = now;
+}
+
+bool SpriteItem::setTime(double now)
+{
+    const int frame = atlas->frameAt(currentAnimation, now - startedAt);
+    if (frame == currentFrame)
+        return false;
+    currentFrame = frame;
+    update();
+    return true;
+}
+
+bool SpriteItem::setMirrored(bool mirror)
+{
+    if (mirror == mirrored)
+        return false;
+    mirrored = mirror;
+    update();
+    return true;
+}
+
+QRectF SpriteItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), size);
+}
+
+void SpriteItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+    if (currentFrame < 0)
+        return;
+    const QRectF target = boundingRect();
+    if (mirrored) {
+        painter->save();
+        painter->translate(target.width(), 0);
+        painter->scale(-1, 1);
+        painter->drawPixmap(target, atlas->pixmap(), atlas->frame(currentFrame));
+        painter->restore();
+    } else {
+        painter->drawPixmap(target, atlas->pixmap(), atlas->frame(currentFrame));
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef SPRITEITEM_H
+#define SPRITEITEM_H
+
+#include <QGraphicsItem>
+#include <memory>
+#include "spriteatlas.h"
+
+// Draws one frame of a shared atlas, scaled into a fixed box. There is no
+// timer: the owner passes the simulation clock to setTime() and the item
+// works out its frame from how long the current animation has played.
+class SpriteItem : public QGraphicsItem
+{
+public:
+    SpriteItem(std::shared_ptr<const SpriteAtlas> atlas, const QSizeF &size, QGraphicsItem *parent = nullptr);
+
+    // Restarts only when the animation actually changes; the new frame
+    // shows from the next setTime()
+    void play(int animationId, double now);
+    int animation() const { return currentAnimation; }
+
+    // Returns true when the visible frame changed
+    bool setTime(double now);
+
+    // Face left by mirroring the frame. Returns true if that changed.
+    bool setMirrored(bool mirrored);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    std::shared_ptr<const SpriteAtlas> atlas;
+    QSizeF size;
+    int currentAnimation{-1};
+    double startedAt{0};
+    int currentFrame{-1};
+    bool mirrored{false};
+};
+
+#endif // SPRITEITEM_H
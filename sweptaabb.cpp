@@ -0,0 +1,65 @@
+#include "sweptaabb.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Penetration, in pixels, still treated as touching. Absorbs float error in
+// positions that were snapped to an edge on the previous tick.
+constexpr float ContactSlop = 0.01f;
+
+// Entry and exit times along one axis. Returns false if the intervals never
+// overlap during the move.
+bool axisInterval(float minA, float maxA, float minB, float maxB, float delta, float &entry, float &exit)
+{
+    if (delta > 0.0f) {
+        entry = (minB - maxA) / delta;
+        exit = (maxB - minA) / delta;
+    } else if (delta < 0.0f) {
+        entry = (maxB - minA) / delta;
+        exit = (minB - maxA) / delta;
+    } else {
+        if (maxA <= minB || minA >= maxB)
+            return false;
+        entry = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+    }
+    return true;
+}
+
+} // namespace
+
+bool sweepAabb(const WorldRect &box, float dx, float dy, const WorldRect &target, SweepHit &hit)
+{
+    if (dx == 0.0f && dy == 0.0f)
+        return false;
+
+    float xEntry, xExit, yEntry, yExit;
+    if (!axisInterval(box.left, box.right(), target.left, target.right(), dx, xEntry, xExit)
+        || !axisInterval(box.top, box.bottom(), target.top, target.bottom(), dy, yEntry, yExit))
+        return false;
+
+    float entry = std::max(xEntry, yEntry);
+    const float exit = std::min(xExit, yExit);
+    if (entry >= exit || entry > 1.0f || exit <= 0.0f)
+        return false;
+
+    if (entry < 0.0f) {
+        // Already overlapping; only a hair's depth along the entry axis counts as contact
+        const float speed = xEntry > yEntry ? std::abs(dx) : std::abs(dy);
+        if (-entry * speed > ContactSlop)
+            return false;
+        entry = 0.0f;
+    }
+
+    hit.time = entry;
+    if (xEntry > yEntry) {
+        hit.normalX = dx > 0.0f ? -1.0f : 1.0f;
+        hit.normalY = 0.0f;
+    } else {
+        hit.normalX = 0.0f;
+        hit.normalY = dy > 0.0f ? -1.0f : 1.0f;
+    }
+    return true;
+}
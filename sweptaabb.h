@@ -0,0 +1,20 @@
+#ifndef SWEPTAABB_H
+#define SWEPTAABB_H
+
+#include "worldrect.h"
+
+struct SweepHit
+{
+    float time{1.0f};   // fraction of the displacement travelled before contact
+    float normalX{0.0f};
+    float normalY{0.0f};
+};
+
+// Continuous test of box moving by (dx, dy) against a stationary target.
+// Returns true when the box starts to overlap the target within the move;
+// boxes that already overlap at the start don't count as a hit, touching
+// edges do when the move is toward the target. Ties between axes resolve to
+// the vertical normal so corner landings stay landings.
+bool sweepAabb(const WorldRect &box, float dx, float dy, const WorldRect &target, SweepHit &hit);
+
+#endif // SWEPTAABB_H
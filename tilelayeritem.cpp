@@ -0,0 +1,97 @@
+#include "tilelayeritem.h"
+#include "levelpalette.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+
+TileLayerItem::TileLayerItem()
+{
+    // Without it exposedRect is always the whole chunk
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void TileLayerItem::setTiles(const WorldRect &clip, const ColliderStore &colliders, const std::vector<int> &indices)
+{
+    prepareGeometryChange();
+    clipRect = QRectF(clip.left, clip.top, clip.width, clip.height);
+    tiles.clear();
+    spikes = QPainterPath();
+
+    const QPolygonF &spikeShape = LevelPalette::instance().spikeShape;
+    const QRectF spikeRect = spikeShape.boundingRect();
+    QRectF covered;
+    for (int index : indices) {
+        const WorldRect r = colliders.rect(index);
+        if (colliders.kind[index] == ColliderKind::Hazard) {
+            addSpikes(r, spikeShape, spikeRect);
+        } else if (colliders.style[index] == PlatformStyle::Ground) {
+            tiles.push_back({r.left, r.top, r.width, r.height, TileKind::Ground});
+        } else if (colliders.style[index] == PlatformStyle::Ledge) {
+            tiles.push_back({r.left, r.top, r.width, r.height, TileKind::Ledge});
+        } else {
+            continue;
+        }
+        // Room for the outline pen
+        covered |= QRectF(r.left, r.top, r.width, r.height).adjusted(-1, -1, 1, 1);
+    }
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [](const Tile &a, const Tile &b) { return a.kind < b.kind; });
+    bounds = covered.intersected(clipRect);
+}
+
+void TileLayerItem::addSpikes(const WorldRect &rect, const QPolygonF &shape, const QRectF &shapeRect)
+{
+    if (shapeRect.width() <= 0 || shapeRect.height() <= 0 || rect.width <= 0)
+        return;
+    // A strip of whole spikes as wide as the hazard, each stretched a little
+    // to fill it; only the ones over this chunk go into the path
+    const int count = std::max(1, int(std::lround(rect.width / shapeRect.width())));
+    const qreal step = qreal(rect.width) / count;
+    const QPolygonF spike = QTransform::fromScale(step / shapeRect.width(), rect.height / shapeRect.height())
+                                .map(shape.translated(-shapeRect.topLeft()));
+    const int first = int(std::clamp(std::floor((clipRect.left() - rect.left) / step), 0.0, qreal(count)));
+    const int last = int(std::clamp(std::ceil((clipRect.right() - rect.left) / step), 0.0, qreal(count)));
+    for (int i = first; i < last; ++i) {
+        spikes.addPolygon(spike.translated(rect.left + i * step, rect.top));
+        spikes.closeSubpath();
+    }
+}
+
+void TileLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    const QRectF exposed = option->exposedRect.intersected(bounds);
+    if (exposed.isEmpty())
+        return;
+
+    const LevelPalette &palette = LevelPalette::instance();
+    painter->save();
+    painter->setClipRect(exposed, Qt::IntersectClip);
+
+    bool ledgeBrush = false;
+    for (const Tile &tile : tiles) {
+        const QRectF r(tile.left, tile.top, tile.width, tile.height);
+        if (!r.adjusted(-1, -1, 1, 1).intersects(exposed))
+            continue;
+        if (tile.kind == TileKind::Ground) {
+            painter->fillRect(r, palette.ground);
+            continue;
+        }
+        if (!ledgeBrush) {
+            painter->setPen(palette.outline);
+            painter->setBrush(palette.ledge);
+            ledgeBrush = true;
+        }
+        // The ledge gradient starts at the top of each ledge
+        painter->setBrushOrigin(r.topLeft());
+        painter->drawRect(r);
+    }
+
+    if (!spikes.isEmpty() && spikes.controlPointRect().intersects(exposed)) {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(palette.spike);
+        painter->drawPath(spikes);
+    }
+    painter->restore();
+}
@@ -0,0 +1,47 @@
+#ifndef TILELAYERITEM_H
+#define TILELAYERITEM_H
+
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <vector>
+#include "colliderstore.h"
+
+// All static geometry of one chunk as a single item: ground, ledges and
+// spikes kept in one compact array and drawn in one paint() with the shared
+// palette, clipped to the chunk and culled to the exposed rect. A dense
+// level costs the scene a handful of items instead of one per collider.
+class TileLayerItem : public QGraphicsItem
+{
+public:
+    TileLayerItem();
+
+    // Replaces the tiles with the given colliders; nothing outside clip is drawn
+    void setTiles(const WorldRect &clip, const ColliderStore &colliders, const std::vector<int> &indices);
+
+    QRectF boundingRect() const override { return bounds; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    void addSpikes(const WorldRect &rect, const QPolygonF &shape, const QRectF &shapeRect);
+
+    enum class TileKind : std::uint8_t
+    {
+        Ground,
+        Ledge
+    };
+    struct Tile
+    {
+        float left;
+        float top;
+        float width;
+        float height;
+        TileKind kind;
+    };
+
+    QRectF clipRect;
+    QRectF bounds;
+    std::vector<Tile> tiles;   // sorted by kind, so each brush is set once
+    QPainterPath spikes;       // every spike in one path, built once
+};
+
+#endif // TILELAYERITEM_H
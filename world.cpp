@@ -0,0 +1,557 @@
+#include "world.h"
+#include "aabbkernel.h"
+#include "inputjournal.h"
+#include "profiler.h"
+#include "sweptaabb.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+World::World()
+{
+    capture(previous);
+    capture(current);
+}
+
+void World::loadLevel(const LevelView &level)
+{
+    const LevelFormat::LevelHeader &header = level.header();
+    width = header.width;
+    height = header.height;
+    spawnX = header.spawnX;
+    spawnY = header.spawnY;
+
+    store.assign(level.colliderCount(), level.left(), level.top(), level.right(), level.bottom(),
+                 level.kinds(), level.styles());
+
+    movers.clear();
+    movers.reserve(level.moverCount() + level.pathCount());
+    // A range mover is a two point ping-pong path, phased so it starts at
+    // its authored rect heading for maxOffset
+    for (int i = 0; i < level.moverCount(); ++i) {
+        const LevelFormat::MoverRecord &record = level.movers()[i];
+        MovingPlatform platform;
+        platform.collider = int(record.collider);
+        const float length = std::abs(record.maxOffset - record.minOffset);
+        platform.path = KinematicPath({{record.minOffset, 0}, {record.maxOffset, 0}}, PathMode::PingPong,
+                                      PathEasing::Linear, record.speed, std::clamp(-record.minOffset, 0.0f, length));
+        movers.push_back(std::move(platform));
+    }
+    for (int i = 0; i < level.pathCount(); ++i) {
+        const LevelFormat::PathRecord &record = level.paths()[i];
+        const PathPoint *points = level.pathPoints() + record.firstPoint;
+        MovingPlatform platform;
+        platform.collider = int(record.collider);
+        platform.path = KinematicPath(std::vector<PathPoint>(points, points + record.pointCount),
+                                      PathMode(record.mode), PathEasing(record.easing), record.speed, record.phase);
+        movers.push_back(std::move(platform));
+    }
+    for (MovingPlatform &platform : movers) {
+        platform.originLeft = store.left[platform.collider];
+        platform.originTop = store.top[platform.collider];
+    }
+
+    buildBroadphase();
+    tickCount = 0;
+    placeMovers();
+
+    entityStore.clear();
+    coinCount = 0;
+    playerId = entityStore.add(EntityKind::Player, {spawnX, spawnY, playerWidth, playerHeight});
+    for (int i = 0; i < level.entityCount() && !entityStore.isFull(); ++i) {
+        const LevelFormat::EntityRecord &record = level.entities()[i];
+        const int id = entityStore.add(EntityKind(record.kind), {record.left, record.top, record.width, record.height});
+        entityStore.velocityX[size_t(id)] = record.speed;
+        entityStore.minX[size_t(id)] = record.minX;
+        entityStore.maxX[size_t(id)] = record.maxX;
+    }
+
+    resetPlayer();
+    events = NoEvent;
+    accumulator = 0.0;
+    capture(current);
+    previous = current;
+    resetHistory();
+}
+
+void World::placeMovers()
+{
+    // Where the paths put every platform at this tick, without giving them a
+    // velocity; the next movePlatforms() measures that from here
+    const double ticks = double(tickCount) * (tickDuration / ReferenceTickSeconds);
+    for (MovingPlatform &platform : movers) {
+        const PathPoint p = platform.path.at(ticks);
+        platform.offsetX = p.x;
+        platform.offsetY = p.y;
+        store.moveTo(platform.collider, platform.originLeft + p.x, platform.originTop + p.y);
+        store.velocityX[platform.collider] = 0;
+        store.velocityY[platform.collider] = 0;
+        grid.move(platform.collider, store.rect(platform.collider));
+    }
+}
+
+void World::buildBroadphase()
+{
+    grid.reset(width, height);
+    for (size_t i = 0; i < store.size(); ++i)
+        grid.insert(int(i), store.rect(int(i)));
+}
+
+void World::setInput(bool moveLeft, bool moveRight)
+{
+    pendingInput.moveLeft = moveLeft;
+    pendingInput.moveRight = moveRight;
+}
+
+void World::requestJump(int phase)
+{
+    pendingInput.jump = true;
+    pendingInput.jumpPhase = std::uint8_t(std::clamp(phase, 0, PlayerInput::JumpPhases - 1));
+}
+
+int World::advance(double elapsedSeconds)
+{
+    const int steps = accumulate(elapsedSeconds);
+    for (int i = 0; i < steps; ++i)
+        step();
+    return steps;
+}
+
+int World::accumulate(double elapsedSeconds)
+{
+    // Never try to catch up more than a few ticks; beyond that we drop time
+    // rather than spiral into ever longer frames
+    accumulator = std::min(accumulator + elapsedSeconds, MaxStepsPerAdvance * tickDuration);
+
+    int steps = 0;
+    while (accumulator >= tickDuration) {
+        accumulator -= tickDuration;
+        ++steps;
+    }
+    return steps;
+}
+
+void World::step()
+{
+    ProfileScope scope("step");
+    if (inputJournal)
+        inputJournal->record(pendingInput);
+    std::swap(previous, current);
+
+    if (pendingInput.rewind) {
+        // Back through the history instead; its newest entry is the state now
+        pendingInput.jump = false;
+        pendingInput.jumpPhase = 0;
+        const int back = std::min(RewindTicksPerStep, rewindableTicks());
+        if (back > 0 && history.rewind(back, stateBlock.data()))
+            applyState(stateBlock.data());
+        capture(current);
+        return;
+    }
+
+    movePlatforms();
+    updatePlayer();
+    updateEntities();
+
+    capture(current);
+    // Don't interpolate across a respawn
+    if (events & PlayerDied)
+        previous = current;
+    ++tickCount;
+
+    saveState(stateBlock.data());
+    history.push(stateBlock.data());
+}
+
+namespace {
+
+// Fixed part of a state block, laid out by hand without padding so equal
+// states are equal bytes; the rewind deltas depend on that. The entity
+// arrays follow it: left, top and velocityX as floats, then alive.
+struct StateHeader
+{
+    std::uint64_t tick;
+    float playerX;
+    float playerY;
+    float verticalVelocity;
+    std::int32_t groundCollider;
+    std::int32_t coins;
+    std::uint32_t entities;
+    std::uint8_t isJumping;
+    std::uint8_t reserved[7];
+};
+static_assert(sizeof(StateHeader) == 40, "state header must stay packed");
+
+} // namespace
+
+std::size_t World::stateSize() const
+{
+    return sizeof(StateHeader) + size_t(entityStore.size()) * (3 * sizeof(float) + 1);
+}
+
+void World::saveState(void *out) const
+{
+    StateHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.tick = tickCount;
+    header.playerX = playerState.x;
+    header.playerY = playerState.y;
+    header.verticalVelocity = playerState.verticalVelocity;
+    header.groundCollider = playerState.groundCollider;
+    header.coins = coinCount;
+    header.entities = std::uint32_t(entityStore.size());
+    header.isJumping = playerState.isJumping;
+
+    std::uint8_t *bytes = static_cast<std::uint8_t *>(out);
+    const size_t n = size_t(entityStore.size());
+    std::memcpy(bytes, &header, sizeof(header));
+    bytes += sizeof(header);
+    std::memcpy(bytes, entityStore.left.data(), n * sizeof(float));
+    std::memcpy(bytes + n * sizeof(float), entityStore.top.data(), n * sizeof(float));
+    std::memcpy(bytes + 2 * n * sizeof(float), entityStore.velocityX.data(), n * sizeof(float));
+    std::memcpy(bytes + 3 * n * sizeof(float), entityStore.alive.data(), n);
+}
+
+void World::restoreState(const void *in)
+{
+    applyState(in);
+    capture(current);
+    previous = current;
+    // What came after the old state isn't this state's past
+    history.clear();
+    saveState(stateBlock.data());
+    history.push(stateBlock.data());
+}
+
+void World::applyState(const void *in)
+{
+    const std::uint8_t *bytes = static_cast<const std::uint8_t *>(in);
+    StateHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    bytes += sizeof(header);
+    // Blocks from another level don't fit this one
+    if (header.entities != std::uint32_t(entityStore.size()))
+        return;
+
+    tickCount = header.tick;
+    playerState.x = header.playerX;
+    playerState.y = header.playerY;
+    playerState.verticalVelocity = header.verticalVelocity;
+    playerState.groundCollider = header.groundCollider;
+    playerState.isJumping = header.isJumping != 0;
+    coinCount = header.coins;
+
+    const size_t n = size_t(entityStore.size());
+    for (size_t i = 0; i < n; ++i) {
+        float x, y;
+        std::memcpy(&x, bytes + i * sizeof(float), sizeof(float));
+        std::memcpy(&y, bytes + (n + i) * sizeof(float), sizeof(float));
+        entityStore.moveTo(int(i), x, y);
+    }
+    std::memcpy(entityStore.velocityX.data(), bytes + 2 * n * sizeof(float), n * sizeof(float));
+    std::memcpy(entityStore.alive.data(), bytes + 3 * n * sizeof(float), n);
+
+    placeMovers();
+    events = NoEvent;
+}
+
+void World::resetHistory()
+{
+    const int ticks = std::max(1, int(RewindSeconds / tickDuration));
+    history.reset(stateSize(), ticks);
+    stateBlock.assign(stateSize(), 0);
+    saveState(stateBlock.data());
+    history.push(stateBlock.data());
+}
+
+std::uint64_t World::stateHash() const
+{
+    // Exactly what saveState() writes, so nothing a replay carries from
+    // tick to tick can diverge without the hash seeing it. Movers follow
+    // from the tick, which is in the block.
+    std::vector<std::uint8_t> block(stateSize());
+    saveState(block.data());
+
+    // FNV-1a over the raw bytes; floats are hashed bit for bit on purpose
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::uint8_t byte : block) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void World::setTickRate(double ticksPerSecond)
+{
+    tickDuration = 1.0 / ticksPerSecond;
+    accumulator = 0.0;
+    // The history holds a number of seconds, which is now a different number of ticks
+    if (!stateBlock.empty())
+        resetHistory();
+}
+
+unsigned World::takeEvents()
+{
+    unsigned taken = events;
+    events = NoEvent;
+    return taken;
+}
+
+void World::movePlatforms()
+{
+    ProfileScope scope("movePlatforms");
+    // Paths are evaluated at the end of this tick rather than advanced by
+    // one, so positions don't drift however long the level runs. The
+    // velocity moveTo records is what carries riders along.
+    const double ticks = double(tickCount + 1) * (tickDuration / ReferenceTickSeconds);
+    moverReach = 0;
+    for (MovingPlatform &platform : movers) {
+        const PathPoint p = platform.path.at(ticks);
+        platform.offsetX = p.x;
+        platform.offsetY = p.y;
+        store.moveTo(platform.collider, platform.originLeft + p.x, platform.originTop + p.y);
+        grid.move(platform.collider, store.rect(platform.collider));
+        moverReach = std::max({moverReach, std::abs(store.velocityX[platform.collider]),
+                               std::abs(store.velocityY[platform.collider])});
+    }
+}
+
+void World::resetPlayer()
+{
+    playerState = PlayerState();
+    playerState.x = spawnX;
+    playerState.y = spawnY;
+    pendingInput = PlayerInput();
+    if (playerId >= 0)
+        entityStore.moveTo(playerId, playerState.x, playerState.y);
+}
+
+void World::killPlayer(DeathCause cause, float x, float y)
+{
+    death.cause = cause;
+    death.x = x;
+    death.y = y;
+    death.tick = tickCount;
+    resetPlayer();
+    events |= PlayerDied;
+}
+
+void World::updatePlayer()
+{
+    ProfileScope scope("updatePlayer");
+    PlayerState &p = playerState;
+    const PlayerInput in = pendingInput;
+    pendingInput.jump = false;
+    pendingInput.jumpPhase = 0;
+    const float scale = float(tickDuration / ReferenceTickSeconds);
+
+    // A jump pressed partway through the tick only flies for the rest of it
+    float airborne = 1.0f;
+    if (in.jump && !p.isJumping && p.y >= 0) {
+        p.verticalVelocity = -jumpForce;
+        p.isJumping = true;
+        airborne = 1.0f - float(in.jumpPhase) / PlayerInput::JumpPhases;
+    }
+
+    // Displacement wanted this tick: walking, gravity, and whatever the
+    // platform we stood on did while it moved
+    float dx = 0;
+    if (in.moveLeft)
+        dx -= playerSpeed * scale;
+    if (in.moveRight)
+        dx += playerSpeed * scale;
+    p.verticalVelocity = std::min(p.verticalVelocity + gravity * scale * airborne, terminalVelocity);
+    float dy = p.verticalVelocity * scale * airborne;
+    if (p.groundCollider >= 0 && !p.isJumping) {
+        dx += store.velocityX[p.groundCollider];
+        dy += store.velocityY[p.groundCollider];
+    }
+
+    // Horizontal boundary checks
+    dx = std::clamp(p.x + dx, 0.0f, width - playerWidth) - p.x;
+
+    const WorldRect start{p.x, p.y, playerWidth, playerHeight};
+
+    // Everything the swept box could touch, padded by how far movers went
+    WorldRect reach = start;
+    reach.left = std::min(start.left, start.left + dx) - moverReach;
+    reach.top = std::min(start.top, start.top + dy) - moverReach;
+    reach.width = playerWidth + std::abs(dx) + 2 * moverReach;
+    reach.height = playerHeight + std::abs(dy) + 2 * moverReach;
+    candidates.clear();
+    grid.query(reach, candidates);
+    lastScanned = int(candidates.size());
+    Profiler::instance().count(Profiler::ScannedCounter, lastScanned);
+
+    batch.gather(store, candidates);
+    const int count = batch.size();
+    hitMask.resize(AabbKernel::maskWords(count));
+
+    // Standing in a hazard at the start of the tick; the same strict overlap
+    // test as QRectF::intersects()
+    bool hitHazard = false;
+    const AabbKernel::Box box{start.left, start.top, start.right(), start.bottom()};
+    AabbKernel::overlapMask(batch.left.data(), batch.top.data(), batch.right.data(), batch.bottom.data(),
+                            count, box, hitMask.data());
+    AabbKernel::forEachHit(hitMask.data(), count, [&](int i) {
+        hitHazard |= batch.kind[i] == ColliderKind::Hazard;
+    });
+    if (hitHazard) {
+        killPlayer(DeathCause::Hazard, p.x, p.y);
+        return;
+    }
+
+    // Slide along the move, stopping at the earliest time of impact each
+    // iteration. Moving colliders are swept in their own frame: they sit at
+    // their start-of-tick position and the player moves relative to them.
+    const bool wasGrounded = p.groundCollider >= 0;
+    p.groundCollider = -1;
+    float x = p.x;
+    float y = p.y;
+    float elapsed = 0;
+    auto colliderAt = [&](int i, float time) {
+        const float back = 1.0f - time;
+        return WorldRect{batch.left[i] - batch.velocityX[i] * back,
+                         batch.top[i] - batch.velocityY[i] * back,
+                         batch.right[i] - batch.left[i],
+                         batch.bottom[i] - batch.top[i]};
+    };
+
+    for (int iteration = 0; iteration < 4 && elapsed < 1.0f; ++iteration) {
+        const float remaining = 1.0f - elapsed;
+        const WorldRect moving{x, y, playerWidth, playerHeight};
+        SweepHit best;
+        int bestIndex = -1;
+
+        for (int i = 0; i < count; ++i) {
+            const WorldRect target = colliderAt(i, elapsed);
+            SweepHit hit;
+            if (!sweepAabb(moving, (dx - batch.velocityX[i]) * remaining,
+                           (dy - batch.velocityY[i]) * remaining, target, hit)
+                || hit.time >= best.time)
+                continue;
+            // One-way platforms only stop you from above
+            if (batch.kind[i] == ColliderKind::OneWay && hit.normalY >= 0)
+                continue;
+            best = hit;
+            bestIndex = i;
+        }
+
+        if (bestIndex < 0) {
+            x += dx * remaining;
+            y += dy * remaining;
+            break;
+        }
+
+        if (batch.kind[bestIndex] == ColliderKind::Hazard) {
+            killPlayer(DeathCause::Hazard, x + dx * remaining * best.time, y + dy * remaining * best.time);
+            return;
+        }
+
+        // Advance to contact, snap to the face we hit and drop the velocity
+        // into it so the rest of the move slides along it
+        elapsed += remaining * best.time;
+        const WorldRect target = colliderAt(bestIndex, elapsed);
+        if (best.normalY < 0) {
+            x += dx * remaining * best.time;
+            y = target.top - playerHeight;
+            dy = batch.velocityY[bestIndex];
+            p.groundCollider = batch.ids[bestIndex];
+        } else if (best.normalY > 0) {
+            x += dx * remaining * best.time;
+            y = target.bottom();
+            dy = batch.velocityY[bestIndex];
+            p.verticalVelocity = 0;
+        } else {
+            x = best.normalX < 0 ? target.left - playerWidth : target.right();
+            y += dy * remaining * best.time;
+            dx = batch.velocityX[bestIndex];
+        }
+    }
+
+    if (p.groundCollider >= 0) {
+        if (!wasGrounded)
+            events |= PlayerLanded;
+        p.verticalVelocity = 0;
+        p.isJumping = false;
+    }
+
+    // Prevent player from going above the top of the screen
+    if (y < 0) {
+        y = 0;
+        p.verticalVelocity = std::max(p.verticalVelocity, 0.0f);
+    }
+
+    // Check if player fell off the bottom of the screen
+    if (y > height) {
+        killPlayer(DeathCause::Fall, x, y);
+        return;
+    }
+
+    p.x = std::clamp(x, 0.0f, width - playerWidth);
+    p.y = y;
+    entityStore.moveTo(playerId, p.x, p.y);
+    if (in.moveRight && p.x >= width - playerWidth)
+        events |= PlayerExited;
+}
+
+void World::updateEntities()
+{
+    ProfileScope scope("updateEntities");
+    const float scale = float(tickDuration / ReferenceTickSeconds);
+    EntityStore &e = entityStore;
+    const int count = e.size();
+
+    for (int i = 0; i < count; ++i) {
+        if (e.kind[size_t(i)] != EntityKind::Walker)
+            continue;
+        const size_t w = size_t(i);
+        float x = e.left[w] + e.velocityX[w] * scale;
+        if (x < e.minX[w]) {
+            x = e.minX[w];
+            e.velocityX[w] = std::abs(e.velocityX[w]);
+        } else if (x > e.maxX[w]) {
+            x = e.maxX[w];
+            e.velocityX[w] = -std::abs(e.velocityX[w]);
+        }
+        e.moveTo(i, x, e.top[w]);
+    }
+
+    // A respawned player gets a tick's grace
+    if (events & PlayerDied)
+        return;
+
+    // Touching entities, with the same strict overlap as the colliders
+    const WorldRect body = e.rect(playerId);
+    const AabbKernel::Box box{body.left, body.top, body.right(), body.bottom()};
+    hitMask.resize(AabbKernel::maskWords(count));
+    AabbKernel::overlapMask(e.left.data(), e.top.data(), e.right.data(), e.bottom.data(), count, box,
+                            hitMask.data());
+    bool killed = false;
+    AabbKernel::forEachHit(hitMask.data(), count, [&](int i) {
+        if (i == playerId || !e.alive[size_t(i)] || killed)
+            return;
+        if (e.kind[size_t(i)] == EntityKind::Pickup) {
+            e.alive[size_t(i)] = 0;
+            ++coinCount;
+            events |= PickupCollected;
+        } else if (e.kind[size_t(i)] == EntityKind::Walker) {
+            killed = true;
+        }
+    });
+    if (killed)
+        killPlayer(DeathCause::Hazard, body.left, body.top);
+}
+
+void World::capture(WorldSnapshot &snapshot) const
+{
+    snapshot.playerX = playerState.x;
+    snapshot.playerY = playerState.y;
+    snapshot.platformOffsetsX.resize(movers.size());
+    snapshot.platformOffsetsY.resize(movers.size());
+    for (size_t i = 0; i < movers.size(); ++i) {
+        snapshot.platformOffsetsX[i] = movers[i].offsetX;
+        snapshot.platformOffsetsY[i] = movers[i].offsetY;
+    }
+    snapshot.entityLefts.assign(entityStore.left.begin(), entityStore.left.end());
+}
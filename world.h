@@ -0,0 +1,213 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <algorithm>
+#include <vector>
+#include "colliderstore.h"
+#include "entitystore.h"
+#include "levelformat.h"
+#include "rewindbuffer.h"
+#include "spatialgrid.h"
+
+// Headless game simulation. Nothing in here depends on Qt, so the world can be
+// stepped without a scene or an event loop (tests, replays, batch runs).
+// Units are scene pixels and reference ticks (1/60 s): velocities are px/tick,
+// gravity px/tick^2. Running at another tick rate scales the motion per step.
+
+// Platform following a kinematic path, as offsets from where its collider
+// was authored. Its collider lives in the world's collider store.
+struct MovingPlatform
+{
+    int collider{-1};
+    float originLeft{0};
+    float originTop{0};
+    KinematicPath path;
+    float offsetX{0};
+    float offsetY{0};
+};
+
+// Controller component of the player entity: the state the swept solver
+// needs beyond the entity's body
+struct PlayerState
+{
+    float x{0};
+    float y{0};
+    float verticalVelocity{0};
+    bool isJumping{false};
+    int groundCollider{-1};  // collider stood on at the end of the last tick
+};
+
+struct PlayerInput
+{
+    bool moveLeft{false};
+    bool moveRight{false};
+    bool jump{false};
+    bool rewind{false};  // held: step back through recent ticks instead
+    // Eighths of the tick already gone when jump was pressed; the jump
+    // only gets the rest of that tick to rise
+    std::uint8_t jumpPhase{0};
+
+    static constexpr int JumpPhases = 8;
+};
+
+enum class DeathCause : std::uint8_t
+{
+    Hazard,  // touched spikes
+    Fall     // dropped off the bottom of the level
+};
+
+// Where and why the player last died, before respawning
+struct DeathRecord
+{
+    DeathCause cause{DeathCause::Fall};
+    float x{0};
+    float y{0};
+    unsigned long long tick{0};
+};
+
+// Everything that moves, captured at the end of a tick
+struct WorldSnapshot
+{
+    float playerX{0};
+    float playerY{0};
+    std::vector<float> platformOffsetsX;
+    std::vector<float> platformOffsetsY;
+    std::vector<float> entityLefts;
+};
+
+class InputJournal;
+
+class World
+{
+public:
+    enum Event : unsigned {
+        NoEvent = 0,
+        PlayerDied = 1 << 0,
+        PlayerLanded = 1 << 1,
+        PlayerExited = 1 << 2,  // walked off the right edge of the level
+        PickupCollected = 1 << 3
+    };
+
+    static constexpr double ReferenceTickSeconds = 1.0 / 60.0;
+    static constexpr int MaxStepsPerAdvance = 5;
+    static constexpr double RewindSeconds = 5.0;
+    static constexpr int RewindTicksPerStep = 2;
+
+    World();
+
+    // Copies the level's colliders and movers; the view isn't kept
+    void loadLevel(const LevelView &level);
+
+    // Input is sampled at the start of the next tick
+    void setInput(bool moveLeft, bool moveRight);
+    // Phase is where in the next tick the press landed, 0 to JumpPhases - 1
+    void requestJump(int phase = 0);
+    // While set, every step goes back RewindTicksPerStep ticks instead of
+    // simulating one. It's input like the rest, so journals replay it.
+    void setRewinding(bool rewinding) { pendingInput.rewind = rewinding; }
+    const PlayerInput &input() const { return pendingInput; }
+
+    // Runs as many fixed ticks as fit in the accumulated time. Returns the
+    // number of ticks taken; the remainder is exposed via interpolationAlpha().
+    int advance(double elapsedSeconds);
+    // advance() without the stepping: adds the time and returns how many
+    // ticks are due, for callers that feed input between ticks
+    int accumulate(double elapsedSeconds);
+    void step();
+
+    // Lower rates trade smoothness for CPU; the swept solver keeps fast
+    // movers from tunneling through thin platforms at any rate
+    void setTickRate(double ticksPerSecond);
+    double tickSeconds() const { return tickDuration; }
+
+    double interpolationAlpha() const { return accumulator / tickDuration; }
+    const WorldSnapshot &previousSnapshot() const { return previous; }
+    const WorldSnapshot &currentSnapshot() const { return current; }
+
+    // Returns and clears the events raised since the last call
+    unsigned takeEvents();
+
+    const PlayerState &player() const { return playerState; }
+    // Valid after a PlayerDied event
+    const DeathRecord &lastDeath() const { return death; }
+    const ColliderStore &colliders() const { return store; }
+    const std::vector<MovingPlatform> &movingPlatforms() const { return movers; }
+    const EntityStore &entities() const { return entityStore; }
+    int playerEntity() const { return playerId; }
+    // Pickups collected on this level
+    int coins() const { return coinCount; }
+
+    // Broadphase candidates the last player update had to test
+    int collidersScanned() const { return lastScanned; }
+
+    unsigned long long tick() const { return tickCount; }
+
+    // Every tick's consumed input is appended to the journal's open segment
+    void setJournal(InputJournal *journal) { inputJournal = journal; }
+    // Hash of everything the simulation carries from tick to tick; equal
+    // hashes after a replay mean it reproduced the session
+    std::uint64_t stateHash() const;
+
+    // Everything step() carries from one tick to the next as one flat block
+    // of stateSize() bytes, the same size for the whole level. Movers aren't
+    // in it since their paths give their place at any tick. Restoring
+    // allocates nothing.
+    std::size_t stateSize() const;
+    void saveState(void *out) const;
+    void restoreState(const void *in);
+    // Ticks of history a rewind can still go back through
+    int rewindableTicks() const { return std::max(0, history.size() - 1); }
+
+    // Tuning, in px/tick
+    float playerSpeed{5.0f};
+    float jumpForce{15.0f};
+    float gravity{0.8f};
+    float terminalVelocity{20.0f};
+    float playerWidth{30.0f};
+    float playerHeight{30.0f};
+    float width{800.0f};
+    float height{600.0f};
+    float spawnX{0.0f};
+    float spawnY{0.0f};
+
+private:
+    void movePlatforms();
+    void updatePlayer();
+    void updateEntities();
+    void resetPlayer();
+    void killPlayer(DeathCause cause, float x, float y);
+    void capture(WorldSnapshot &snapshot) const;
+    void buildBroadphase();
+    void placeMovers();
+    void applyState(const void *in);
+    void resetHistory();
+
+    PlayerState playerState;
+    PlayerInput pendingInput;
+    DeathRecord death;
+    ColliderStore store;
+    std::vector<MovingPlatform> movers;
+    EntityStore entityStore;
+    int playerId{-1};
+    int coinCount{0};
+    SpatialGrid grid;  // ids are collider store indices
+    std::vector<int> candidates;
+    ColliderBatch batch;
+    std::vector<std::uint32_t> hitMask;
+    float moverReach{0};  // largest distance any collider moved last tick
+
+    WorldSnapshot previous;
+    WorldSnapshot current;
+    double tickDuration{ReferenceTickSeconds};
+    double accumulator{0.0};
+    unsigned long long tickCount{0};
+    unsigned events{NoEvent};
+    int lastScanned{0};
+    InputJournal *inputJournal{nullptr};
+
+    // State after each of the last RewindSeconds of ticks, newest last
+    RewindBuffer history;
+    std::vector<std::uint8_t> stateBlock;
+};
+
+#endif // WORLD_H
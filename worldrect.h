@@ -0,0 +1,23 @@
+#ifndef WORLDRECT_H
+#define WORLDRECT_H
+
+// Axis-aligned rectangle in scene pixels, shared by the simulation modules
+struct WorldRect
+{
+    float left{0};
+    float top{0};
+    float width{0};
+    float height{0};
+
+    float right() const { return left + width; }
+    float bottom() const { return top + height; }
+
+    // Same semantics as QRectF::intersects(): touching edges don't count
+    bool intersects(const WorldRect &other) const
+    {
+        return left < other.right() && other.left < right()
+            && top < other.bottom() && other.top < bottom();
+    }
+};
+
+#endif // WORLDRECT_H